@@ -1,321 +1,3844 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <string.h>
 #include <pthread.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sys/sysinfo.h>
 #include "valloc.h"
 
-// Variable thread-local pour stocker l'ID du thread
-__thread int thread_id = -1;
-int next_thread_id = 0;
-pthread_mutex_t thread_id_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Séquences restartables : enregistrées par la glibc (2.35+) pour chaque thread,
+// sections critiques écrites pour x86-64
+#if defined(__x86_64__) && defined(__has_include)
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#define VALLOC_HAVE_RSEQ 1
+#endif
+#endif
+
+// Politique mbind : nœud préféré, sans échec d'allocation si le nœud est plein
+#define VALLOC_MPOL_PREFERRED 1
+
+// Dernier cache utilisé par le thread : évite pthread_getspecific sur le chemin rapide
+static __thread MemoryAllocator* tls_allocator = NULL;
+static __thread uint64_t tls_epoch = 0;
+static __thread ThreadCache* tls_cache = NULL;
+
+// Générations des allocateurs : un allocateur réinitialisé à la même adresse
+// n'est jamais confondu avec le précédent dans les caches TLS
+static uint64_t next_epoch = 0;
+
+// Le thread enregistre son cache (pthread_setspecific peut rappeler malloc
+// quand la bibliothèque est préchargée) ou a déjà vidé son cache en se terminant :
+// il est servi sans cache
+static __thread bool tls_no_cache = false;
+
+// Nœud NUMA imposé au thread par valloc_set_thread_node (-1 : détecté par getcpu)
+static __thread int tls_node = -1;
+
+// Profileur : octets restant avant le prochain échantillon, générateur du tirage
+// géométrique (0 : pas encore initialisé) et garde contre la récursion (backtrace
+// et stdio peuvent rappeler malloc quand la bibliothèque est préchargée)
+static __thread int64_t tls_sample_left = 0;
+static __thread uint64_t tls_sample_rng = 0;
+static __thread bool tls_in_profile = false;
+
+// Allocateur dont le profil est écrit à la réception du signal de valloc_profile_signal
+static MemoryAllocator* profile_signal_allocator = NULL;
+
+/**
+ * @brief Alloue de la mémoire interne à l'allocateur (tables, caches)
+ * 
+ * Les métadonnées sont prises directement à mmap, jamais à malloc :
+ * l'allocateur peut ainsi remplacer malloc lui-même (LD_PRELOAD).
+ * 
+ * @param size Taille demandée
+ * @return void* Zone remise à zéro, NULL en cas d'échec
+ */
+static void* meta_alloc(size_t size) {
+    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+/**
+ * @brief Libère une zone obtenue par meta_alloc
+ * 
+ * @param ptr Zone à libérer (NULL accepté)
+ * @param size Taille passée à meta_alloc
+ */
+static void meta_free(void* ptr, size_t size) {
+    if (ptr) munmap(ptr, size);
+}
+
+/**
+ * @brief Retrouve un cache du registre par son indice
+ * 
+ * Le registre est alloué par tranches qui ne sont jamais déplacées :
+ * lecture sans verrou.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param index Indice du cache
+ * @return ThreadCache* Cache enregistré, NULL si l'indice est libre
+ */
+static ThreadCache* thread_cache_at(MemoryAllocator* allocator, int index) {
+    if (index < 0 || index >= MAX_THREADS) return NULL;
+    ThreadCache** chunk = __atomic_load_n(&allocator->thread_caches[index >> CACHE_REGISTRY_CHUNK_SHIFT],
+                                          __ATOMIC_ACQUIRE);
+    if (chunk == NULL) return NULL;
+    return __atomic_load_n(&chunk[index & (CACHE_REGISTRY_CHUNK_SIZE - 1)], __ATOMIC_ACQUIRE);
+}
+
+// Compteur d'activité du thread : dans son cache, dont il est le seul écrivain
+// (écriture ordinaire, lue atomiquement par valloc_stats), ou compteur partagé
+// mis à jour atomiquement pour un thread sans cache
+#define STAT_ADD(allocator, cache, field, n) do { \
+        if (cache) { \
+            __atomic_store_n(&(cache)->stats.field, (cache)->stats.field + (n), __ATOMIC_RELAXED); \
+        } else { \
+            __atomic_add_fetch(&(allocator)->shared_stats.field, (n), __ATOMIC_RELAXED); \
+        } \
+    } while (0)
+
+/**
+ * @brief Verrouille un mutex en comptant les attentes
+ * 
+ * @param mutex Mutex à verrouiller
+ * @param contention Compteur incrémenté si le mutex était déjà pris
+ */
+static inline void stat_lock(pthread_mutex_t* mutex, uint64_t* contention) {
+    if (pthread_mutex_trylock(mutex) != 0) {
+        __atomic_add_fetch(contention, 1, __ATOMIC_RELAXED);
+        pthread_mutex_lock(mutex);
+    }
+}
+
+/**
+ * @brief Verrouille le mutex global (table des blocs, index, registre)
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ */
+static void global_lock(MemoryAllocator* allocator) {
+    stat_lock(&allocator->mutex, &allocator->pool_stats.global_contention);
+}
+
+/**
+ * @brief Verrouille le mutex d'une arène
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène à verrouiller
+ */
+static void arena_lock(MemoryAllocator* allocator, Arena* arena) {
+    stat_lock(&arena->mutex, &allocator->pool_stats.arena_contention);
+}
+
+/**
+ * @brief Verrouille la liste centrale d'une classe de petits objets
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène de la classe
+ * @param size_class Classe de taille
+ * @return SlabClass* Liste verrouillée
+ */
+static SlabClass* class_lock(MemoryAllocator* allocator, Arena* arena, size_t size_class) {
+    SlabClass* cls = &arena->classes[size_class];
+    stat_lock(&cls->mutex, &allocator->pool_stats.class_contention);
+    return cls;
+}
+
+/**
+ * @brief Compte une zone nouvellement projetée
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param size Taille de la zone
+ */
+static void stat_mapped(MemoryAllocator* allocator, size_t size) {
+    const size_t page = (size_t)1 << VALLOC_PAGE_SHIFT;
+    PoolStats* stats = &allocator->pool_stats;
+    size_t mapped = __atomic_add_fetch(&stats->bytes_mapped, (size + page - 1) & ~(page - 1), __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&stats->bytes_mapped_peak, __ATOMIC_RELAXED);
+    while (mapped > peak && !__atomic_compare_exchange_n(&stats->bytes_mapped_peak, &peak, mapped, true,
+                                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * @brief Rend une zone de blocs au système, en la décomptant
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Début de la zone
+ * @param size Taille de la zone
+ */
+static void pool_unmap(MemoryAllocator* allocator, void* ptr, size_t size) {
+    const size_t page = (size_t)1 << VALLOC_PAGE_SHIFT;
+    munmap(ptr, size);
+    __atomic_add_fetch(&allocator->pool_stats.munmap_calls, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&allocator->pool_stats.bytes_mapped, (size + page - 1) & ~(page - 1), __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Calcule la classe de taille d'un petit objet
+ * 
+ * Multiples de 16 octets jusqu'à 128, puis 4 classes par puissance de 2
+ * jusqu'à SLAB_MAX_SIZE : la perte interne reste inférieure à 25 %.
+ * 
+ * @param size Taille demandée (au plus SLAB_MAX_SIZE)
+ * @return size_t Indice de la classe
+ */
+static size_t size_class_index(size_t size) {
+    if (size <= 128) return size <= 16 ? 0 : (size - 1) / 16;
+    size_t log = (sizeof(size_t) * 8 - 1) - (size_t)__builtin_clzl(size - 1);
+    return 8 + ((log - 7) << 2) + ((size - 1 - ((size_t)1 << log)) >> (log - 2));
+}
+
+/**
+ * @brief Taille des objets d'une classe
+ * 
+ * @param size_class Indice de la classe
+ * @return size_t Taille arrondie servie pour cette classe
+ */
+static size_t size_class_size(size_t size_class) {
+    if (size_class < 8) return (size_class + 1) * 16;
+    size_t base = (size_t)1 << (7 + ((size_class - 8) >> 2));
+    return base + (((size_class - 8) & 3) + 1) * (base >> 2);
+}
+
+/**
+ * @brief Calcule la classe du cache thread-local d'une taille de bloc
+ * 
+ * Les petits objets gardent leur classe de slab (tailles exactes).
+ * Au-delà, 4 classes par puissance de 2 jusqu'à CACHE_MAX_SIZE :
+ * un bloc est rangé dans la classe dont le minimum est inférieur
+ * ou égal à sa taille.
+ * 
+ * @param size Taille du bloc
+ * @return size_t Indice de la classe, NUM_CACHE_CLASSES si la taille n'est pas mise en cache
+ */
+static size_t cache_class_index(size_t size) {
+    if (size <= SLAB_MAX_SIZE) return size_class_index(size);
+    if (size > CACHE_MAX_SIZE) return NUM_CACHE_CLASSES;
+    size_t log = (sizeof(size_t) * 8 - 1) - (size_t)__builtin_clzl(size);
+    return NUM_SIZE_CLASSES + ((log - 13) << 2) + ((size >> (log - 2)) & 3);
+}
+
+/**
+ * @brief Plus petite taille d'une classe du cache ou des statistiques
+ * 
+ * @param index Indice de la classe (NUM_CACHE_CLASSES : au-delà de CACHE_MAX_SIZE)
+ * @return size_t Taille minimale des blocs de la classe
+ */
+static size_t cache_class_size(size_t index) {
+    if (index < NUM_SIZE_CLASSES) return index ? size_class_size(index - 1) + 1 : 1;
+    if (index >= NUM_CACHE_CLASSES) return CACHE_MAX_SIZE + 1;
+    if (index == NUM_SIZE_CLASSES) return SLAB_MAX_SIZE + 1;
+    size_t k = index - NUM_SIZE_CLASSES;
+    size_t log = 13 + (k >> 2);
+    return (4 + (k & 3)) << (log - 2);
+}
+
+/**
+ * @brief Retire la tête d'une liste du cache
+ */
+static inline void* cache_bin_pop(CacheBin* bin) {
+    CacheBlock* block = bin->head;
+    bin->head = block->next;
+    bin->count--;
+    return block;
+}
+
+/**
+ * @brief Tente d'allouer de la mémoire depuis le cache thread-local
+ * 
+ * Dépile en O(1) la liste de la classe de la taille demandée. Pour
+ * les grands blocs, la tête de la classe est prise si elle suffit,
+ * sinon celle de la classe suivante, dont tous les blocs suffisent.
+ * Seul le thread propriétaire y accède : aucun verrou n'est pris.
+ * 
+ * @param cache Cache du thread pour l'allocation
+ * @param size Taille du bloc de mémoire nécessaire
+ * @return void* Pointeur vers le bloc en cache, NULL si aucun bloc approprié trouvé
+ */
+void* cache_allocate(ThreadCache* cache, size_t size) {
+    if (!cache) return NULL;
+
+    size_t index = cache_class_index(size);
+    if (index >= NUM_CACHE_CLASSES) return NULL;
+
+    CacheBin* bin = &cache->bins[index];
+    if (bin->head && bin->head->size >= size) return cache_bin_pop(bin);
+    if (index >= NUM_SIZE_CLASSES && index + 1 < NUM_CACHE_CLASSES && bin[1].head) {
+        return cache_bin_pop(&bin[1]);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Tente de mettre en cache un bloc de mémoire libéré
+ * 
+ * Si la liste de sa classe est pleine, le bloc est refusé et
+ * l'appelant se charge de le retourner à son pool.
+ * Seul le thread propriétaire y accède : aucun verrou n'est pris.
+ * 
+ * @param cache Cache du thread pour le stockage
+ * @param ptr Pointeur vers le bloc de mémoire
+ * @param size Taille du bloc de mémoire
+ * @return bool true si le bloc a été mis en cache, false sinon
+ */
+bool cache_free(ThreadCache* cache, void* ptr, size_t size) {
+    if (!cache || !ptr) return false;
+
+    size_t index = cache_class_index(size);
+    if (index >= NUM_CACHE_CLASSES) return false;
+
+    CacheBin* bin = &cache->bins[index];
+    if (bin->count >= bin->limit) return false;
+
+    CacheBlock* block = (CacheBlock*)ptr;
+    block->size = size;
+    block->next = bin->head;
+    bin->head = block;
+    bin->count++;
+    return true;
+}
+
+/**
+ * @brief Rend un bloc au cache d'un autre thread
+ * 
+ * Empilement sans verrou (pile de Treiber) ; le propriétaire retire
+ * toute la pile d'un coup, il n'y a donc pas de problème ABA.
+ * 
+ * @param cache Cache destinataire
+ * @param ptr Pointeur vers le bloc
+ * @param size Taille du bloc
+ */
+void cache_free_remote(ThreadCache* cache, void* ptr, size_t size) {
+    if (!cache || !ptr) return;
+
+    CacheBlock* node = (CacheBlock*)ptr;
+    node->size = size;
+    __atomic_add_fetch(&cache->remote_count, 1, __ATOMIC_RELAXED);
+    node->next = __atomic_load_n(&cache->remote, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&cache->remote, &node->next, node, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * @brief Retire toute la pile distante d'un cache
+ * 
+ * @param cache Cache dont la pile est vidée
+ * @return CacheBlock* Blocs en attente, chaînés par next
+ */
+static CacheBlock* cache_take_remote(ThreadCache* cache) {
+    CacheBlock* list = __atomic_exchange_n(&cache->remote, NULL, __ATOMIC_ACQUIRE);
+    uint32_t count = 0;
+    for (CacheBlock* block = list; block; block = block->next) count++;
+    if (count) __atomic_sub_fetch(&cache->remote_count, count, __ATOMIC_RELAXED);
+    return list;
+}
+
+/**
+ * @brief Vide un cache thread-local sans rendre ses blocs
+ * 
+ * La pile distante n'est pas touchée : d'autres threads peuvent y empiler
+ * à tout moment, seul un échange atomique la retire.
+ * 
+ * @param allocator Allocateur dont la profondeur par classe est reprise
+ * @param cache Cache à réinitialiser
+ */
+static void cache_reset(MemoryAllocator* allocator, ThreadCache* cache) {
+    for (size_t c = 0; c < NUM_CACHE_CLASSES; c++) {
+        cache->bins[c].head = NULL;
+        cache->bins[c].count = 0;
+        cache->bins[c].limit = allocator->cache_depth[c];
+    }
+}
+
+/**
+ * @brief Configure la profondeur des caches thread-locaux pour une taille
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param size Taille représentative de la classe
+ * @param depth Nombre maximum de blocs conservés par thread
+ * @return int 0 en cas de succès, -1 si la taille n'est pas mise en cache
+ */
+int valloc_set_cache_depth(MemoryAllocator* allocator, size_t size, int depth) {
+    if (allocator == NULL || !allocator->initialized || size == 0 || depth < 0) {
+        return -1;
+    }
+
+    size_t index = cache_class_index(size);
+    if (index >= NUM_CACHE_CLASSES) return -1;
+
+    global_lock(allocator);
+    allocator->cache_depth[index] = (uint32_t)depth;
+    for (int i = 0; i < allocator->num_threads; i++) {
+        ThreadCache* cache = thread_cache_at(allocator, i);
+        if (cache) cache->bins[index].limit = (uint32_t)depth;
+    }
+    pthread_mutex_unlock(&allocator->mutex);
+    return 0;
+}
+
+/**
+ * @brief Borne le cache des grandes projections
+ * 
+ * Un bloc de plus de CACHE_MAX_SIZE libéré reste projeté, pour servir une
+ * demande suivante, tant que les blocs recyclés de son arène ne dépassent
+ * pas max_bytes ; au-delà, il est rendu au système.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param max_bytes Octets recyclés par arène (0 : grands blocs toujours rendus)
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+int valloc_set_large_cache(MemoryAllocator* allocator, size_t max_bytes) {
+    if (allocator == NULL || !allocator->initialized) {
+        return -1;
+    }
+    __atomic_store_n(&allocator->large_cache_limit, max_bytes, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/**
+ * @brief Découpe une adresse en indices de la table des pages
+ * 
+ * @param ptr Adresse à indexer
+ * @param i0 Indice dans la racine
+ * @param i1 Indice dans le nœud intermédiaire
+ * @param i2 Indice dans la feuille
+ * @return bool false si l'adresse dépasse les 48 bits couverts par la table
+ */
+static bool pagemap_index(const void* ptr, size_t* i0, size_t* i1, size_t* i2) {
+    uintptr_t page = (uintptr_t)ptr >> VALLOC_PAGE_SHIFT;
+    if (page >> (3 * PAGEMAP_LEVEL_BITS)) return false;
+
+    *i0 = (page >> (2 * PAGEMAP_LEVEL_BITS)) & (PAGEMAP_LEVEL_SIZE - 1);
+    *i1 = (page >> PAGEMAP_LEVEL_BITS) & (PAGEMAP_LEVEL_SIZE - 1);
+    *i2 = page & (PAGEMAP_LEVEL_SIZE - 1);
+    return true;
+}
+
+/**
+ * @brief Recherche le bloc associé à la page d'une adresse
+ * 
+ * Trois accès mémoire au plus, quel que soit le nombre de blocs.
+ * 
+ * @param map Table des pages
+ * @param ptr Adresse recherchée
+ * @return MemoryBlock* Bloc enregistré pour cette page, NULL sinon
+ */
+static MemoryBlock* pagemap_get(const PageMap* map, const void* ptr) {
+    size_t i0, i1, i2;
+    if (!pagemap_index(ptr, &i0, &i1, &i2)) return NULL;
+
+    PageMapNode* node = __atomic_load_n(&map->nodes[i0], __ATOMIC_ACQUIRE);
+    if (!node) return NULL;
+    PageMapLeaf* leaf = __atomic_load_n(&node->leaves[i1], __ATOMIC_ACQUIRE);
+    if (!leaf) return NULL;
+    return __atomic_load_n(&leaf->blocks[i2], __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Associe la page d'une adresse à un bloc
+ * 
+ * Alloue les nœuds intermédiaires manquants. Les écritures sont publiées
+ * atomiquement : pagemap_get peut être appelée sans verrou pendant
+ * qu'un autre thread modifie la table sous le mutex global.
+ * 
+ * @param map Table des pages
+ * @param ptr Adresse à enregistrer
+ * @param block Bloc associé (NULL pour effacer l'entrée)
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+static int pagemap_set(PageMap* map, const void* ptr, MemoryBlock* block) {
+    size_t i0, i1, i2;
+    if (!pagemap_index(ptr, &i0, &i1, &i2)) return -1;
+
+    PageMapNode* node = map->nodes[i0];
+    if (!node) {
+        if (!block) return 0;
+        node = (PageMapNode*)meta_alloc(sizeof(PageMapNode));
+        if (!node) return -1;
+        __atomic_store_n(&map->nodes[i0], node, __ATOMIC_RELEASE);
+    }
+    PageMapLeaf* leaf = node->leaves[i1];
+    if (!leaf) {
+        if (!block) return 0;
+        leaf = (PageMapLeaf*)meta_alloc(sizeof(PageMapLeaf));
+        if (!leaf) return -1;
+        __atomic_store_n(&node->leaves[i1], leaf, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&leaf->blocks[i2], block, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Associe toutes les pages d'une plage à un bloc
+ * 
+ * En cas d'échec, les pages déjà enregistrées sont effacées.
+ * 
+ * @param map Table des pages
+ * @param ptr Début de la plage (aligné sur une page)
+ * @param size Taille de la plage
+ * @param block Bloc associé (NULL pour effacer les entrées)
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+static int pagemap_set_range(PageMap* map, const void* ptr, size_t size, MemoryBlock* block) {
+    const size_t page = (size_t)1 << VALLOC_PAGE_SHIFT;
+    for (size_t off = 0; off < size; off += page) {
+        if (pagemap_set(map, (const char*)ptr + off, block) != 0) {
+            pagemap_set_range(map, ptr, off, NULL);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Libère tous les nœuds de la table des pages
+ * 
+ * @param map Table des pages
+ */
+static void pagemap_destroy(PageMap* map) {
+    for (size_t i = 0; i < PAGEMAP_LEVEL_SIZE; i++) {
+        PageMapNode* node = map->nodes[i];
+        if (!node) continue;
+        for (size_t j = 0; j < PAGEMAP_LEVEL_SIZE; j++) {
+            meta_free(node->leaves[j], sizeof(PageMapLeaf));
+        }
+        meta_free(node, sizeof(PageMapNode));
+    }
+    meta_free(map, sizeof(PageMap));
+}
+
+/**
+ * @brief Retrouve un emplacement de la table par son indice
+ * 
+ * La tranche k contient 2^(block_chunk_shift + k) emplacements.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param index Indice de l'emplacement (inférieur à total_blocks)
+ * @return MemoryBlock* Emplacement correspondant
+ */
+static MemoryBlock* block_at(MemoryAllocator* allocator, size_t index) {
+    size_t shift = allocator->block_chunk_shift;
+    size_t chunk = (sizeof(size_t) * 8 - 1) - (size_t)__builtin_clzl((index >> shift) + 1);
+    size_t first = (((size_t)1 << chunk) - 1) << shift;
+    return &allocator->block_chunks[chunk][index - first];
+}
+
+/**
+ * @brief Ajoute une tranche à la table des blocs
+ * 
+ * Les tranches existantes ne sont jamais déplacées : les pointeurs vers
+ * les blocs (index des pages, listes) restent valides.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+static int block_table_grow(MemoryAllocator* allocator) {
+    size_t chunk = allocator->block_chunk_count;
+    if (chunk == BLOCK_TABLE_CHUNKS) return -1;
+
+    // Mémoire à zéro, dont les pages ne sont touchées qu'à la distribution des emplacements
+    size_t count = (size_t)1 << (allocator->block_chunk_shift + chunk);
+    MemoryBlock* blocks = (MemoryBlock*)meta_alloc(count * sizeof(MemoryBlock));
+    if (blocks == NULL) return -1;
+
+    allocator->block_chunks[chunk] = blocks;
+    allocator->block_chunk_count++;
+    allocator->total_blocks += count;
+    return 0;
+}
+
+/**
+ * @brief Garantit un emplacement libre en tête de free_slots
+ * 
+ * Réutilise d'abord les emplacements rendus, puis distribue le suivant
+ * jamais utilisé, en agrandissant la table si nécessaire.
+ * Doit être appelée avec le mutex global verrouillé.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @return MemoryBlock* Emplacement libre (tête de free_slots), NULL en cas d'échec
+ */
+static MemoryBlock* block_slot_reserve(MemoryAllocator* allocator) {
+    if (allocator->free_slots) return allocator->free_slots;
+
+    if (allocator->next_block == allocator->total_blocks && block_table_grow(allocator) != 0) {
+        return NULL;
+    }
+
+    MemoryBlock* block = block_at(allocator, allocator->next_block++);
+    block->status = true;
+    block->owner = -1;
+    block->next = NULL;
+    allocator->free_slots = block;
+    return block;
+}
+
+/**
+ * @brief Rend un emplacement de la table disponible
+ * 
+ * Retire le bloc de l'index et le remet dans la liste des emplacements libres.
+ * Doit être appelée avec le mutex global verrouillé.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param block Emplacement à libérer
+ */
+static void release_slot(MemoryAllocator* allocator, MemoryBlock* block) {
+    if (block->slab) {
+        pagemap_set_range(allocator->page_map, block->adress, block->size, NULL);
+    } else {
+        pagemap_set(allocator->page_map, block->adress, NULL);
+    }
+    block->adress = NULL;
+    block->size = 0;
+    block->status = true;
+    block->recycled = false;
+    block->slab = false;
+    block->owner = -1;
+    block->next = allocator->free_slots;
+    allocator->free_slots = block;
+}
+
+/**
+ * @brief Calcule la classe de recyclage d'une taille
+ * 
+ * Classes géométriques : chaque puissance de 2 est découpée en
+ * 2^RECYCLE_BIN_SUBDIV_BITS classes de largeur égale. Tous les blocs
+ * d'une classe ont une taille dans [min(classe), min(classe + 1)).
+ * 
+ * @param size Taille du bloc
+ * @return size_t Indice de la classe
+ */
+static size_t recycle_bin_index(size_t size) {
+    if (size < 16) return 0;
+    size_t log = (sizeof(size_t) * 8 - 1) - (size_t)__builtin_clzl(size);
+    size_t sub = (size >> (log - RECYCLE_BIN_SUBDIV_BITS)) & ((1 << RECYCLE_BIN_SUBDIV_BITS) - 1);
+    return ((log - 4) << RECYCLE_BIN_SUBDIV_BITS) + sub;
+}
+
+/**
+ * @brief Insère un bloc recyclé en tête de sa classe
+ * 
+ * Doit être appelée avec le mutex de l'arène verrouillé.
+ * 
+ * @param arena Arène du bloc
+ * @param block Bloc recyclé
+ */
+static void recycle_bin_push(Arena* arena, MemoryBlock* block) {
+    size_t bin = recycle_bin_index(block->size);
+    arena->recycled_bytes += block->size;
+    block->prev = NULL;
+    block->next = arena->recycled_bins[bin];
+    if (block->next) block->next->prev = block;
+    arena->recycled_bins[bin] = block;
+    arena->recycled_bitmap[bin / 64] |= 1ULL << (bin % 64);
+}
+
+/**
+ * @brief Retire un bloc de sa classe de recyclage en O(1)
+ * 
+ * Doit être appelée avec le mutex de l'arène verrouillé.
+ * 
+ * @param arena Arène du bloc
+ * @param block Bloc recyclé
+ */
+static void recycle_bin_remove(Arena* arena, MemoryBlock* block) {
+    size_t bin = recycle_bin_index(block->size);
+    arena->recycled_bytes -= block->size;
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        arena->recycled_bins[bin] = block->next;
+    }
+    if (block->next) block->next->prev = block->prev;
+    block->next = NULL;
+    block->prev = NULL;
+    if (arena->recycled_bins[bin] == NULL) {
+        arena->recycled_bitmap[bin / 64] &= ~(1ULL << (bin % 64));
+    }
+}
+
+/**
+ * @brief Cherche la première classe de recyclage non vide à partir de bin
+ * 
+ * @param arena Arène parcourue
+ * @param bin Indice de départ
+ * @return size_t Indice trouvé, NUM_RECYCLE_BINS si toutes sont vides
+ */
+static size_t recycle_bin_next(const Arena* arena, size_t bin) {
+    if (bin >= NUM_RECYCLE_BINS) return NUM_RECYCLE_BINS;
+
+    size_t word = bin / 64;
+    uint64_t bits = arena->recycled_bitmap[word] & (~0ULL << (bin % 64));
+    while (bits == 0) {
+        if (++word >= RECYCLE_BITMAP_WORDS) return NUM_RECYCLE_BINS;
+        bits = arena->recycled_bitmap[word];
+    }
+    return word * 64 + (size_t)__builtin_ctzll(bits);
+}
+
+/**
+ * @brief Cherche la dernière classe de recyclage non vide jusqu'à bin inclus
+ * 
+ * @param arena Arène parcourue
+ * @param bin Indice de départ
+ * @return size_t Indice trouvé, NUM_RECYCLE_BINS si toutes sont vides
+ */
+static size_t recycle_bin_prev(const Arena* arena, size_t bin) {
+    if (bin >= NUM_RECYCLE_BINS) bin = NUM_RECYCLE_BINS - 1;
+
+    size_t word = bin / 64;
+    uint64_t bits = arena->recycled_bitmap[word] & (~0ULL >> (63 - bin % 64));
+    while (bits == 0) {
+        if (word-- == 0) return NUM_RECYCLE_BINS;
+        bits = arena->recycled_bitmap[word];
+    }
+    return word * 64 + 63 - (size_t)__builtin_clzll(bits);
+}
+
+/**
+ * @brief Extrait le bloc recyclé le mieux adapté à une taille
+ * 
+ * La classe de la taille demandée peut contenir des blocs trop petits :
+ * on y cherche le meilleur ajustement sur RECYCLE_BIN_SEARCH_DEPTH blocs.
+ * Sinon, la tête de la plus petite classe supérieure non vide convient
+ * forcément, trouvée via le bitmap.
+ * Doit être appelée avec le mutex de l'arène verrouillé.
+ * 
+ * @param arena Arène où chercher
+ * @param size Taille demandée
+ * @return MemoryBlock* Bloc retiré de sa classe, NULL si aucun ne convient
+ */
+static MemoryBlock* recycle_bin_take(Arena* arena, size_t size) {
+    size_t bin = recycle_bin_index(size);
+    MemoryBlock* best = NULL;
+
+    if (arena->recycled_bins[bin]) {
+        int depth = 0;
+        for (MemoryBlock* b = arena->recycled_bins[bin];
+             b && depth < RECYCLE_BIN_SEARCH_DEPTH; b = b->next, depth++) {
+            if (b->size >= size && (best == NULL || b->size < best->size)) {
+                best = b;
+                if (b->size == size) break;
+            }
+        }
+    }
+
+    if (best == NULL) {
+        size_t next = recycle_bin_next(arena, bin + 1);
+        if (next == NUM_RECYCLE_BINS) return NULL;
+        best = arena->recycled_bins[next];
+    }
+
+    recycle_bin_remove(arena, best);
+    return best;
+}
+
+_Static_assert(sizeof(SlabChunk) <= SLAB_SPAN_SIZE, "l'en-tête du chunk doit tenir dans la span 0");
+_Static_assert(SLAB_SPANS_PER_CHUNK <= 64, "free_spans est un bitmap de 64 bits");
+
+// Spans utilisables d'un chunk (la span 0 porte l'en-tête)
+#define SLAB_ALL_SPANS ((SLAB_SPANS_PER_CHUNK == 64 ? ~0ULL : (1ULL << SLAB_SPANS_PER_CHUNK) - 1) & ~1ULL)
+
+/**
+ * @brief Ajoute un chunk à la liste des chunks disposant de spans libres
+ */
+static void slab_chunk_link(Arena* arena, SlabChunk* chunk) {
+    chunk->prev = NULL;
+    chunk->next = arena->slab_chunks;
+    if (chunk->next) chunk->next->prev = chunk;
+    arena->slab_chunks = chunk;
+}
+
+/**
+ * @brief Retire un chunk de la liste des chunks disposant de spans libres
+ */
+static void slab_chunk_unlink(Arena* arena, SlabChunk* chunk) {
+    if (chunk->prev) {
+        chunk->prev->next = chunk->next;
+    } else {
+        arena->slab_chunks = chunk->next;
+    }
+    if (chunk->next) chunk->next->prev = chunk->prev;
+    chunk->next = NULL;
+    chunk->prev = NULL;
+}
+
+/**
+ * @brief Ajoute une span à la liste des spans non pleines de sa classe
+ * 
+ * Doit être appelée avec le mutex de la classe verrouillé.
+ */
+static void slab_span_link(Arena* arena, SlabSpan* span) {
+    SlabClass* cls = &arena->classes[span->size_class];
+    span->prev = NULL;
+    span->next = cls->partial;
+    if (span->next) span->next->prev = span;
+    cls->partial = span;
+}
+
+/**
+ * @brief Retire une span de la liste des spans non pleines de sa classe
+ * 
+ * Doit être appelée avec le mutex de la classe verrouillé.
+ */
+static void slab_span_unlink(Arena* arena, SlabSpan* span) {
+    if (span->prev) {
+        span->prev->next = span->next;
+    } else {
+        arena->classes[span->size_class].partial = span->next;
+    }
+    if (span->next) span->next->prev = span->prev;
+    span->next = NULL;
+    span->prev = NULL;
+}
+
+/**
+ * @brief Projette une zone de mémoire alignée
+ * 
+ * Au-delà d'une page, la projection est agrandie de l'alignement puis
+ * découpée : seules les pages de la zone alignée restent projetées.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur (statistiques)
+ * @param size Taille de la zone
+ * @param alignment Alignement demandé (puissance de 2)
+ * @return void* Zone alignée, NULL en cas d'échec
+ */
+static void* map_aligned(MemoryAllocator* allocator, size_t size, size_t alignment) {
+    const size_t page = (size_t)1 << VALLOC_PAGE_SHIFT;
+    PoolStats* stats = &allocator->pool_stats;
+    __atomic_add_fetch(&stats->mmap_calls, 1, __ATOMIC_RELAXED);
+    if (alignment <= page) {
+        void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) return NULL;
+        stat_mapped(allocator, size);
+        return ptr;
+    }
+
+    size_t length = (size + page - 1) & ~(page - 1);
+    size_t mapped = length + alignment - page;
+    char* raw = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+
+    char* base = (char*)(((uintptr_t)raw + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    if (base > raw) {
+        munmap(raw, base - raw);
+        __atomic_add_fetch(&stats->munmap_calls, 1, __ATOMIC_RELAXED);
+    }
+    if (raw + mapped > base + length) {
+        munmap(base + length, (raw + mapped) - (base + length));
+        __atomic_add_fetch(&stats->munmap_calls, 1, __ATOMIC_RELAXED);
+    }
+    stat_mapped(allocator, length);
+    return base;
+}
+
+/**
+ * @brief Projette la mémoire d'un chunk de slabs
+ * 
+ * Un chunk occupe exactement une grande page. Avec VALLOC_HUGETLB, il est
+ * pris dans les grandes pages réservées ; au premier échec, l'allocateur
+ * bascule définitivement sur les grandes pages transparentes.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param hugetlb Mis à true si le chunk vient des grandes pages réservées
+ * @return void* Chunk aligné sur sa taille, NULL en cas d'échec
+ */
+static void* map_chunk(MemoryAllocator* allocator, bool* hugetlb) {
+    *hugetlb = false;
+    if (__atomic_load_n(&allocator->flags, __ATOMIC_RELAXED) & VALLOC_HUGETLB) {
+        void* ptr = mmap(NULL, SLAB_CHUNK_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        __atomic_add_fetch(&allocator->pool_stats.mmap_calls, 1, __ATOMIC_RELAXED);
+        if (ptr != MAP_FAILED) {
+            stat_mapped(allocator, SLAB_CHUNK_SIZE);
+            *hugetlb = true;
+            return ptr;
+        }
+        __atomic_or_fetch(&allocator->flags, VALLOC_HUGE_PAGES, __ATOMIC_RELAXED);
+        __atomic_and_fetch(&allocator->flags, ~VALLOC_HUGETLB, __ATOMIC_RELAXED);
+    }
+
+    // Chunk aligné sur sa taille, donc sur une grande page
+    void* base = map_aligned(allocator, SLAB_CHUNK_SIZE, SLAB_CHUNK_SIZE);
+    if (base && (__atomic_load_n(&allocator->flags, __ATOMIC_RELAXED) & VALLOC_HUGE_PAGES)) {
+        madvise(base, SLAB_CHUNK_SIZE, MADV_HUGEPAGE);
+    }
+    return base;
+}
+
+/**
+ * @brief Lie une zone projetée au nœud de son arène
+ * 
+ * Sans effet pour un nœud simulé, absent du système.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène destinataire de la zone
+ * @param ptr Début de la zone (aligné sur une page)
+ * @param size Taille de la zone
+ */
+static void arena_bind(MemoryAllocator* allocator, Arena* arena, void* ptr, size_t size) {
+    if (allocator->system_nodes <= 1 || arena->node >= allocator->system_nodes) return;
+
+    unsigned long mask = 1UL << arena->node;
+    syscall(SYS_mbind, ptr, size, VALLOC_MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0);
+}
+
+/**
+ * @brief Enregistre une zone projetée dans la table et dans l'index
+ * 
+ * Prend le mutex global, le temps d'obtenir un emplacement.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Début de la zone
+ * @param size Taille de la zone
+ * @param slab true pour un chunk de slabs (toutes ses pages sont indexées)
+ * @param arena Arène de la zone
+ * @return MemoryBlock* Bloc occupé, NULL en cas d'échec
+ */
+static MemoryBlock* block_register(MemoryAllocator* allocator, void* ptr, size_t size, bool slab, Arena* arena) {
+    global_lock(allocator);
+    MemoryBlock* block = block_slot_reserve(allocator);
+    int err = block == NULL ? -1
+            : slab ? pagemap_set_range(allocator->page_map, ptr, size, block)
+                   : pagemap_set(allocator->page_map, ptr, block);
+    if (err != 0) {
+        pthread_mutex_unlock(&allocator->mutex);
+        return NULL;
+    }
+
+    allocator->free_slots = block->next;
+    block->next = NULL;
+    block->prev = NULL;
+    block->adress = ptr;
+    block->size = size;
+    block->status = false;
+    block->recycled = false;
+    block->slab = slab;
+    block->sampled = false;
+    block->purged = false;
+    block->owner = -1;
+    block->arena = (int)(arena - allocator->arenas);
+    pthread_mutex_unlock(&allocator->mutex);
+
+    __atomic_add_fetch(&allocator->used_blocks, 1, __ATOMIC_RELAXED);
+    return block;
+}
+
+/**
+ * @brief Retire un bloc de la table et de l'index, sous le mutex global
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param block Bloc dont la mémoire a été rendue au système
+ */
+static void block_unregister(MemoryAllocator* allocator, MemoryBlock* block) {
+    global_lock(allocator);
+    release_slot(allocator, block);
+    pthread_mutex_unlock(&allocator->mutex);
+}
+
+/**
+ * @brief Obtient un nouveau chunk de slabs auprès du système
+ * 
+ * Le chunk est aligné sur SLAB_CHUNK_SIZE, lié au nœud de l'arène,
+ * enregistré comme un bloc de la table et toutes ses pages sont indexées
+ * vers ce bloc.
+ * Doit être appelée avec le mutex de l'arène verrouillé.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène du chunk
+ * @return SlabChunk* Chunk initialisé, NULL en cas d'échec
+ */
+static SlabChunk* slab_chunk_create(MemoryAllocator* allocator, Arena* arena) {
+    bool hugetlb;
+    char* base = map_chunk(allocator, &hugetlb);
+    if (base == NULL) return NULL;
+    arena_bind(allocator, arena, base, SLAB_CHUNK_SIZE);
+
+    MemoryBlock* block = block_register(allocator, base, SLAB_CHUNK_SIZE, true, arena);
+    if (block == NULL) {
+        pool_unmap(allocator, base, SLAB_CHUNK_SIZE);
+        return NULL;
+    }
+
+    // La mémoire fraîchement mappée est déjà à zéro
+    SlabChunk* chunk = (SlabChunk*)base;
+    chunk->block = block;
+    chunk->free_spans = SLAB_ALL_SPANS;
+    // Spans jamais touchées : rien à purger
+    chunk->purged_spans = SLAB_ALL_SPANS;
+    chunk->hugetlb = hugetlb;
+    slab_chunk_link(arena, chunk);
+    return chunk;
+}
+
+/**
+ * @brief Prépare une span inutilisée pour une classe de taille
+ * 
+ * Doit être appelée avec les mutex de la classe et de l'arène verrouillés.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène de la span
+ * @param size_class Classe de taille des objets
+ * @return SlabSpan* Span insérée dans la liste de sa classe, NULL en cas d'échec
+ */
+static SlabSpan* slab_span_create(MemoryAllocator* allocator, Arena* arena, size_t size_class) {
+    SlabChunk* chunk = arena->slab_chunks;
+    if (chunk == NULL) {
+        chunk = slab_chunk_create(allocator, arena);
+        if (chunk == NULL) return NULL;
+    }
+
+    size_t idx = (size_t)__builtin_ctzll(chunk->free_spans);
+    chunk->free_spans &= ~(1ULL << idx);
+    chunk->purged_spans &= ~(1ULL << idx);
+    if (chunk->free_spans == 0) slab_chunk_unlink(arena, chunk);
+
+    SlabSpan* span = &chunk->spans[idx];
+    span->start = (char*)chunk + idx * SLAB_SPAN_SIZE;
+    span->size_class = (uint32_t)size_class;
+    span->object_size = (uint32_t)size_class_size(size_class);
+    span->capacity = (uint32_t)(SLAB_SPAN_SIZE / span->object_size);
+    span->free_count = span->capacity;
+    span->hint = 0;
+    span->owner = SPAN_UNOWNED;
+
+    memset(span->bitmap, 0, sizeof(span->bitmap));
+    for (uint32_t i = 0; i < span->capacity / 64; i++) {
+        span->bitmap[i] = ~0ULL;
+    }
+    if (span->capacity % 64) {
+        span->bitmap[span->capacity / 64] = (1ULL << (span->capacity % 64)) - 1;
+    }
+
+    slab_span_link(arena, span);
+    return span;
+}
+
+/**
+ * @brief Rend une span vide à son chunk
+ * 
+ * Le chunk est retourné au système une fois toutes ses spans rendues.
+ * Doit être appelée avec le mutex de la classe verrouillé ; prend celui
+ * de l'arène.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène de la span
+ * @param span Span entièrement libre
+ */
+static void slab_span_release(MemoryAllocator* allocator, Arena* arena, SlabSpan* span) {
+    SlabChunk* chunk = (SlabChunk*)((uintptr_t)span & ~(uintptr_t)(SLAB_CHUNK_SIZE - 1));
+    size_t idx = (size_t)(span - chunk->spans);
+
+    slab_span_unlink(arena, span);
+    arena_lock(allocator, arena);
+    span->capacity = 0;
+    span->idle_pass = __atomic_load_n(&allocator->scavenger.pass, __ATOMIC_RELAXED);
+
+    if (chunk->free_spans == 0) slab_chunk_link(arena, chunk);
+    chunk->free_spans |= 1ULL << idx;
+
+    if (chunk->free_spans == SLAB_ALL_SPANS) {
+        MemoryBlock* block = chunk->block;
+        slab_chunk_unlink(arena, chunk);
+        pool_unmap(allocator, block->adress, block->size);
+        block_unregister(allocator, block);
+        __atomic_sub_fetch(&allocator->used_blocks, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&arena->mutex);
+}
+
+/**
+ * @brief Enregistre le thread qui taille des objets dans une span
+ * 
+ * Une span n'a de propriétaire que si un seul thread y a taillé depuis
+ * qu'elle est vide : ses objets peuvent alors lui être rendus. Dès qu'un
+ * second thread (ou un thread sans cache) y taille, elle est partagée et
+ * ses objets sont libérés localement.
+ * Doit être appelée avec le mutex de la classe verrouillé.
+ * 
+ * @param span Span dans laquelle des objets sont taillés
+ * @param owner Indice du cache du thread appelant (-1 si aucun)
+ */
+static inline void slab_claim(SlabSpan* span, int owner) {
+    int32_t current = span->owner;
+    if (current == owner || current == SPAN_SHARED) return;
+    int32_t claimed = current == SPAN_UNOWNED && owner >= 0 ? owner : SPAN_SHARED;
+    __atomic_store_n(&span->owner, claimed, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Alloue un objet d'une classe de taille dans les slabs
+ * 
+ * Doit être appelée avec le mutex de la classe verrouillé ; celui de
+ * l'arène n'est pris que pour tailler une nouvelle span.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène du thread appelant
+ * @param size_class Classe de taille
+ * @param owner Indice du cache du thread appelant (-1 si aucun)
+ * @return void* Objet alloué, NULL en cas d'échec
+ */
+static void* slab_alloc(MemoryAllocator* allocator, Arena* arena, size_t size_class, int owner) {
+    SlabSpan* span = arena->classes[size_class].partial;
+    if (span == NULL) {
+        arena_lock(allocator, arena);
+        span = slab_span_create(allocator, arena, size_class);
+        pthread_mutex_unlock(&arena->mutex);
+        if (span == NULL) return NULL;
+    }
+
+    size_t word = span->hint;
+    while (span->bitmap[word] == 0) word++;
+    size_t bit = (size_t)__builtin_ctzll(span->bitmap[word]);
+    span->bitmap[word] &= span->bitmap[word] - 1;
+    span->hint = (uint32_t)word;
+    slab_claim(span, owner);
+
+    if (--span->free_count == 0) slab_span_unlink(arena, span);
+    return span->start + (word * 64 + bit) * span->object_size;
+}
+
+/**
+ * @brief Retrouve la span d'une adresse d'un chunk, sans vérifier l'objet
+ * 
+ * @param block Bloc du chunk contenant ptr
+ * @param ptr Adresse dans le chunk
+ * @return SlabSpan* Span couvrant ptr, NULL hors des spans
+ */
+static inline SlabSpan* slab_span_of(MemoryBlock* block, const void* ptr) {
+    SlabChunk* chunk = (SlabChunk*)block->adress;
+    size_t idx = (size_t)((const char*)ptr - (char*)chunk) >> SLAB_SPAN_SHIFT;
+    if (idx == 0) return NULL;
+
+    SlabSpan* span = &chunk->spans[idx];
+    return span->capacity ? span : NULL;
+}
+
+/**
+ * @brief Retrouve la span et l'indice d'un objet d'un chunk
+ * 
+ * Ne lit que les champs fixés à la création de la span : utilisable
+ * sans verrou pour un objet alloué, dont la span ne peut pas disparaître.
+ * 
+ * @param block Bloc du chunk contenant ptr
+ * @param ptr Pointeur vers l'objet
+ * @param index Indice de l'objet dans sa span
+ * @return SlabSpan* Span de l'objet, NULL si ptr n'est pas un début d'objet
+ */
+static SlabSpan* slab_locate(MemoryBlock* block, const void* ptr, size_t* index) {
+    SlabSpan* span = slab_span_of(block, ptr);
+    if (span == NULL) return NULL;
+
+    size_t offset = (size_t)((const char*)ptr - span->start);
+    if (offset % span->object_size != 0) return NULL;
+    size_t i = offset / span->object_size;
+    if (i >= span->capacity) return NULL;
+
+    *index = i;
+    return span;
+}
+
+/**
+ * @brief Retrouve la span et l'indice d'un objet alloué dans un chunk
+ * 
+ * Doit être appelée avec le mutex de la classe de l'objet verrouillé.
+ * 
+ * @param block Bloc du chunk contenant ptr
+ * @param ptr Pointeur vers l'objet
+ * @param index Indice de l'objet dans sa span
+ * @return SlabSpan* Span de l'objet, NULL si ptr n'est pas un objet alloué
+ */
+static SlabSpan* slab_find(MemoryBlock* block, const void* ptr, size_t* index) {
+    SlabSpan* span = slab_locate(block, ptr, index);
+
+    // Objet déjà libre : double libération ignorée
+    if (span && (span->bitmap[*index / 64] & (1ULL << (*index % 64)))) return NULL;
+    return span;
+}
+
+/**
+ * @brief Rend un objet à sa span
+ * 
+ * Une span entièrement libre est rendue à son chunk, sauf si c'est
+ * la dernière span non pleine de sa classe (évite les allers-retours
+ * avec le système sur un motif allocation/libération).
+ * Doit être appelée avec le mutex de la classe verrouillé.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène de la span
+ * @param span Span de l'objet
+ * @param index Indice de l'objet dans la span
+ */
+static void slab_free(MemoryAllocator* allocator, Arena* arena, SlabSpan* span, size_t index) {
+    span->bitmap[index / 64] |= 1ULL << (index % 64);
+    if (index / 64 < span->hint) span->hint = (uint32_t)(index / 64);
+
+    if (span->free_count++ == 0) slab_span_link(arena, span);
+    if (span->free_count == span->capacity) {
+        // Span vide : le prochain thread qui y taille en redevient seul propriétaire
+        __atomic_store_n(&span->owner, SPAN_UNOWNED, __ATOMIC_RELAXED);
+        if (span->next || span->prev) slab_span_release(allocator, arena, span);
+    }
+}
+
+/**
+ * @brief Rend un bloc à son pool : sa span ou le système
+ * 
+ * Prend le mutex de la classe de l'objet, ou celui de l'arène d'un grand bloc.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param block Bloc de la table contenant ptr
+ * @param ptr Pointeur vers le bloc de mémoire
+ */
+static void pool_free(MemoryAllocator* allocator, MemoryBlock* block, void* ptr) {
+    if (block == NULL) return;
+
+    Arena* arena = &allocator->arenas[block->arena];
+    if (block->slab) {
+        size_t index;
+        SlabSpan* span = slab_locate(block, ptr, &index);
+        if (span == NULL) return;
+        SlabClass* cls = class_lock(allocator, arena, span->size_class);
+        span = slab_find(block, ptr, &index);
+        if (span) slab_free(allocator, arena, span, index);
+        pthread_mutex_unlock(&cls->mutex);
+        return;
+    }
+
+    arena_lock(allocator, arena);
+    if (block->adress == ptr && !block->status) {
+        block->status = true;
+        pool_unmap(allocator, ptr, block->size);
+        block_unregister(allocator, block);
+        __atomic_sub_fetch(&allocator->used_blocks, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&arena->mutex);
+}
+
+/**
+ * @brief Place un bloc occupé dans une classe de recyclage de son arène
+ * 
+ * Doit être appelée avec le mutex de l'arène verrouillé.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène du bloc
+ * @param block Bloc dédié (hors slabs) à recycler
+ * @param ptr Pointeur vers le bloc de mémoire
+ */
+static void arena_recycle(MemoryAllocator* allocator, Arena* arena, MemoryBlock* block, void* ptr) {
+    if (block->adress == ptr && !block->status) {
+        block->status = true;
+        block->recycled = true;
+        block->purged = false;
+        block->idle_pass = __atomic_load_n(&allocator->scavenger.pass, __ATOMIC_RELAXED);
+        recycle_bin_push(arena, block);
+        __atomic_sub_fetch(&allocator->used_blocks, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&allocator->recycled_blocks, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Libère un bloc dédié dans le cache des projections de son arène
+ * 
+ * Le bloc reste projeté dans les classes de recyclage, réutilisable par
+ * toute demande qu'il peut servir, tant que les blocs recyclés de l'arène
+ * ne dépassent pas large_cache_limit ; au-delà, il est rendu au système.
+ * Prend le mutex de l'arène du bloc.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param block Bloc dédié (hors slabs) à recycler
+ * @param ptr Pointeur vers le bloc de mémoire
+ */
+static void recycle_block(MemoryAllocator* allocator, MemoryBlock* block, void* ptr) {
+    Arena* arena = &allocator->arenas[block->arena];
+    size_t limit = __atomic_load_n(&allocator->large_cache_limit, __ATOMIC_RELAXED);
+    arena_lock(allocator, arena);
+    if (block->adress == ptr && !block->status && arena->recycled_bytes + block->size <= limit) {
+        arena_recycle(allocator, arena, block, ptr);
+        pthread_mutex_unlock(&arena->mutex);
+        return;
+    }
+    pthread_mutex_unlock(&arena->mutex);
+    pool_free(allocator, block, ptr);
+}
+
+/**
+ * @brief Sert un bloc dédié depuis les blocs recyclés de l'arène
+ * 
+ * Le plus petit bloc recyclé suffisant est réutilisé ; s'il dépasse la
+ * demande de plus d'un huitième, la fin de sa projection est rendue au
+ * système. Faute de bloc suffisant, un grand bloc recyclé d'au moins la
+ * moitié de la demande est agrandi par mremap : ses pages déjà présentes
+ * ne sont ni reprises ni remises à zéro.
+ * Doit être appelée avec le mutex de l'arène verrouillé.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène du thread appelant
+ * @param size Taille demandée (au-delà de SLAB_MAX_SIZE)
+ * @return MemoryBlock* Bloc retiré des classes de recyclage, NULL si aucun ne convient
+ */
+static MemoryBlock* large_reuse(MemoryAllocator* allocator, Arena* arena, size_t size) {
+    const size_t page = (size_t)1 << VALLOC_PAGE_SHIFT;
+    size_t needed = (size + page - 1) & ~(page - 1);
+
+    MemoryBlock* block = recycle_bin_take(arena, size);
+    if (block) {
+        size_t mapped = (block->size + page - 1) & ~(page - 1);
+        if (mapped - needed > needed / 8) {
+            pool_unmap(allocator, (char*)block->adress + needed, mapped - needed);
+            block->size = needed;
+        }
+        if (block->size > CACHE_MAX_SIZE) {
+            __atomic_add_fetch(&allocator->pool_stats.large_reuses, 1, __ATOMIC_RELAXED);
+        }
+        return block;
+    }
+    if (size <= CACHE_MAX_SIZE) return NULL;
+
+    // Plus grand bloc recyclé en dessous de la demande
+    size_t bin = recycle_bin_prev(arena, recycle_bin_index(size));
+    if (bin == NUM_RECYCLE_BINS) return NULL;
+    block = arena->recycled_bins[bin];
+    if (block->size < needed / 2) return NULL;
+    recycle_bin_remove(arena, block);
+
+    size_t mapped = (block->size + page - 1) & ~(page - 1);
+    void* ptr = mremap(block->adress, mapped, needed, MREMAP_MAYMOVE);
+    __atomic_add_fetch(&allocator->pool_stats.mremap_calls, 1, __ATOMIC_RELAXED);
+    if (ptr == MAP_FAILED) {
+        recycle_bin_push(arena, block);
+        return NULL;
+    }
+    if (ptr != block->adress) {
+        global_lock(allocator);
+        if (pagemap_set(allocator->page_map, ptr, block) != 0) {
+            // Index plein : la projection revient à sa place d'origine
+            void* back = mremap(ptr, needed, mapped, MREMAP_MAYMOVE | MREMAP_FIXED, block->adress);
+            (void)back;
+            pthread_mutex_unlock(&allocator->mutex);
+            recycle_bin_push(arena, block);
+            return NULL;
+        }
+        pagemap_set(allocator->page_map, block->adress, NULL);
+        block->adress = ptr;
+        pthread_mutex_unlock(&allocator->mutex);
+    }
+    stat_mapped(allocator, needed - mapped);
+    block->size = needed;
+    __atomic_add_fetch(&allocator->pool_stats.large_reuses, 1, __ATOMIC_RELAXED);
+    return block;
+}
+
+/**
+ * @brief Arène du thread appelant
+ * 
+ * Le nœud vient de getcpu (ou de valloc_set_thread_node). Sur un système
+ * à un seul nœud dont la topologie est simulée, le processeur choisit l'arène.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @return Arena* Arène du nœud du thread
+ */
+static Arena* thread_arena(MemoryAllocator* allocator) {
+    int count = allocator->num_arenas;
+    if (count == 1) return &allocator->arenas[0];
+
+    int node = tls_node;
+    if (node < 0) {
+        unsigned int cpu = 0, cpu_node = 0;
+        getcpu(&cpu, &cpu_node);
+        node = allocator->system_nodes > 1 ? (int)cpu_node : (int)cpu;
+    }
+    return &allocator->arenas[node % count];
+}
+
+/**
+ * @brief Nombre de blocs d'un transfert entre un cache et les listes centrales
+ * 
+ * La moitié de la profondeur de la classe : un remplissage laisse de la
+ * place aux libérations, un vidage garde de quoi servir les allocations.
+ * 
+ * @param bin Liste du cache
+ * @return uint32_t Taille du lot, au moins 1
+ */
+static inline uint32_t cache_batch(const CacheBin* bin) {
+    return bin->limit > 1 ? bin->limit / 2 : 1;
+}
+
+/**
+ * @brief Rend une liste de blocs aux listes centrales de leurs arènes
+ * 
+ * Un seul verrouillage par liste centrale : les petits objets retournent
+ * à leur span sous le verrou de leur classe, les grands blocs aux classes
+ * de recyclage sous celui de leur arène (la purge en rend les pages au
+ * système s'ils restent inutilisés).
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param list Blocs chaînés par CacheBlock::next
+ */
+static void cache_release(MemoryAllocator* allocator, CacheBlock* list) {
+    while (list) {
+        // Blocs des autres listes centrales : mis de côté pour un tour suivant
+        CacheBlock* others = NULL;
+        pthread_mutex_t* held = NULL;
+
+        while (list) {
+            CacheBlock* node = list;
+            list = node->next;
+            MemoryBlock* block = pagemap_get(allocator->page_map, node);
+            if (block == NULL) continue;
+
+            Arena* arena = &allocator->arenas[block->arena];
+            size_t index;
+            SlabSpan* span = NULL;
+            if (block->slab) {
+                span = slab_locate(block, node, &index);
+                if (span == NULL) continue;
+            }
+
+            pthread_mutex_t* mutex = span ? &arena->classes[span->size_class].mutex : &arena->mutex;
+            if (held == NULL) {
+                held = mutex;
+                if (span) {
+                    class_lock(allocator, arena, span->size_class);
+                } else {
+                    arena_lock(allocator, arena);
+                }
+            } else if (mutex != held) {
+                node->next = others;
+                others = node;
+                continue;
+            }
+
+            // node est détaché : sa span peut rendre son chunk au système
+            if (span) {
+                span = slab_find(block, node, &index);
+                if (span) slab_free(allocator, arena, span, index);
+            } else {
+                arena_recycle(allocator, arena, block, node);
+            }
+        }
+
+        if (held) pthread_mutex_unlock(held);
+        list = others;
+    }
+}
+
+/**
+ * @brief Met en cache un bloc dont la liste de classe est pleine
+ * 
+ * Les blocs les plus anciens de la liste, la moitié de sa profondeur,
+ * retournent aux listes centrales en un seul lot ; le bloc libéré prend
+ * la tête. Une classe de profondeur nulle rend directement le bloc.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param cache Cache du thread propriétaire
+ * @param ptr Pointeur vers le bloc
+ * @param size Taille du bloc (au plus CACHE_MAX_SIZE)
+ */
+static void cache_overflow(MemoryAllocator* allocator, ThreadCache* cache, void* ptr, size_t size) {
+    CacheBin* bin = &cache->bins[cache_class_index(size)];
+    CacheBlock* list = (CacheBlock*)ptr;
+
+    if (bin->limit == 0) {
+        list->next = NULL;
+    } else {
+        // Les blocs récents, en tête, restent dans le cache
+        uint32_t keep = bin->count > cache_batch(bin) ? bin->count - cache_batch(bin) : 0;
+        CacheBlock** link = &bin->head;
+        for (uint32_t i = 0; i < keep; i++) link = &(*link)->next;
+        list = *link;
+        *link = NULL;
+        bin->count = keep;
+        cache_free(cache, ptr, size);
+    }
+
+    STAT_ADD(allocator, cache, cache_flushes, 1);
+    cache_release(allocator, list);
+}
+
+/**
+ * @brief Prend un lot d'objets dans les spans partielles d'une classe
+ * 
+ * Sans créer de span : seuls les objets déjà disponibles sont pris.
+ * Doit être appelée avec le mutex de la classe verrouillé.
+ * 
+ * @param arena Arène de la classe
+ * @param size_class Classe de taille
+ * @param owner Indice du cache destinataire (-1 si aucun)
+ * @param count Nombre d'objets souhaités
+ * @param list Objets pris, chaînés par CacheBlock::next (taille renseignée)
+ * @return uint32_t Nombre d'objets pris
+ */
+static uint32_t slab_take(Arena* arena, size_t size_class, int owner, uint32_t count, CacheBlock** list) {
+    size_t size = size_class_size(size_class);
+    uint32_t taken = 0;
+    SlabSpan* span;
+    while (taken < count && (span = arena->classes[size_class].partial) != NULL) {
+        // Objets pris mot par mot dans le bitmap de la span
+        size_t word = span->hint;
+        while (taken < count && span->free_count > 0) {
+            while (span->bitmap[word] == 0) word++;
+            size_t bit = (size_t)__builtin_ctzll(span->bitmap[word]);
+            span->bitmap[word] &= span->bitmap[word] - 1;
+            span->free_count--;
+
+            CacheBlock* block = (CacheBlock*)(span->start + (word * 64 + bit) * span->object_size);
+            block->size = size;
+            block->next = *list;
+            *list = block;
+            taken++;
+        }
+        span->hint = (uint32_t)word;
+        slab_claim(span, owner);
+        if (span->free_count == 0) slab_span_unlink(arena, span);
+    }
+    return taken;
+}
+
+/**
+ * @brief Remplit la liste d'une classe de petits objets depuis les slabs
+ * 
+ * Prend un lot d'objets dans les spans partielles de l'arène : le verrou
+ * de la classe, déjà pris pour l'échec du cache, sert ainsi les
+ * allocations suivantes.
+ * Doit être appelée avec le mutex de la classe verrouillé.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param cache Cache du thread appelant
+ * @param arena Arène du thread appelant
+ * @param size_class Classe de taille
+ */
+static void cache_refill(MemoryAllocator* allocator, ThreadCache* cache, Arena* arena, size_t size_class) {
+    CacheBin* bin = &cache->bins[size_class];
+    uint32_t target = bin->count + cache_batch(bin);
+    if (target > bin->limit) target = bin->limit;
+    if (bin->count >= target) return;
+
+    STAT_ADD(allocator, cache, cache_refills, 1);
+    CacheBlock* list = NULL;
+    uint32_t taken = slab_take(arena, size_class, cache->index, target - bin->count, &list);
+    if (taken == 0) return;
+
+    // Lot placé devant les blocs déjà en cache
+    CacheBlock* tail = list;
+    while (tail->next) tail = tail->next;
+    tail->next = bin->head;
+    bin->head = list;
+    bin->count += taken;
+}
+
+/**
+ * @brief Récupère les blocs rendus par d'autres threads
+ * 
+ * Vide la pile distante en une seule opération atomique et range
+ * chaque bloc dans la liste de sa classe. Une liste pleine rend ses
+ * blocs les plus anciens aux listes centrales.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param cache Cache du thread propriétaire
+ */
+static void cache_drain_remote(MemoryAllocator* allocator, ThreadCache* cache) {
+    CacheBlock* list = cache_take_remote(cache);
+
+    while (list) {
+        CacheBlock* block = list;
+        list = list->next;
+        if (!cache_free(cache, block, block->size)) {
+            cache_overflow(allocator, cache, block, block->size);
+        }
+    }
+}
+
+/**
+ * @brief Rend tout le contenu d'un cache au pool global
+ * 
+ * Blocs des listes et blocs en attente sur le canal distant retournent
+ * à leur span pour les petits objets, aux classes de recyclage de leur
+ * arène pour les grands blocs.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param cache Cache à vider
+ */
+static void cache_flush(MemoryAllocator* allocator, ThreadCache* cache) {
+    CacheBlock* list = cache_take_remote(cache);
+
+    for (size_t c = 0; c < NUM_CACHE_CLASSES; c++) {
+        CacheBin* bin = &cache->bins[c];
+        while (bin->head) {
+            CacheBlock* block = cache_bin_pop(bin);
+            block->next = list;
+            list = block;
+        }
+    }
+
+    cache_release(allocator, list);
+}
+
+#ifdef VALLOC_HAVE_RSEQ
+
+/**
+ * @brief Zone rseq du thread appelant, enregistrée par la glibc
+ */
+static inline struct rseq* rseq_area(void) {
+    return (struct rseq*)((char*)__builtin_thread_pointer() + __rseq_offset);
+}
+
+/**
+ * @brief Cache du processeur du thread appelant
+ * 
+ * Sert aux compteurs et à vérifier que le thread peut utiliser les
+ * séquences restartables ; les opérations sur les piles relisent le
+ * processeur dans leur section critique.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @return CpuCache* Cache du processeur, NULL sans caches par processeur ou sans rseq
+ */
+static inline CpuCache* cpu_cache_current(MemoryAllocator* allocator) {
+    if (allocator->cpu_caches == NULL) return NULL;
+    int cpu = (int)__atomic_load_n(&rseq_area()->cpu_id, __ATOMIC_RELAXED);
+    if (cpu < 0 || cpu >= allocator->num_cpus) return NULL;
+    return &allocator->cpu_caches[cpu];
+}
+
+/**
+ * @brief Dépile un objet du cache du processeur courant
+ * 
+ * Section critique rseq : le processeur est lu, puis le sommet de la pile,
+ * et l'écriture de count valide l'opération. Préempté ou migré avant
+ * cette écriture, le thread reprend au début (étiquette d'abandon,
+ * précédée de la signature RSEQ_SIG).
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param size_class Classe de taille
+ * @return void* Objet, NULL si la pile est vide
+ */
+static inline void* cpu_cache_pop(MemoryAllocator* allocator, size_t size_class) {
+    struct rseq* rs = rseq_area();
+    char* base = (char*)&allocator->cpu_caches[0].bins[size_class];
+    uint64_t stride = sizeof(CpuCache);
+    uint32_t num_cpus = (uint32_t)allocator->num_cpus;
+    void* ptr;
+
+    __asm__ __volatile__(
+        ".pushsection __rseq_cs, \"aw\"\n\t"
+        ".balign 32\n\t"
+        ".Lvalloc_pop_cs%=:\n\t"
+        ".long 0, 0\n\t"
+        ".quad .Lvalloc_pop_start%=, .Lvalloc_pop_commit%= - .Lvalloc_pop_start%=, .Lvalloc_pop_abort%=\n\t"
+        ".popsection\n\t"
+        ".pushsection __rseq_failure, \"ax\"\n\t"
+        ".byte 0x0f, 0xb9, 0x3d\n\t"
+        ".long 0x53053053\n\t"
+        ".Lvalloc_pop_abort%=:\n\t"
+        "jmp .Lvalloc_pop_retry%=\n\t"
+        ".popsection\n\t"
+        ".Lvalloc_pop_retry%=:\n\t"
+        "xorl %k[ptr], %k[ptr]\n\t"
+        "leaq .Lvalloc_pop_cs%=(%%rip), %%rax\n\t"
+        "movq %%rax, %[rseq_cs]\n\t"
+        ".Lvalloc_pop_start%=:\n\t"
+        "movl %[cpu_id], %%eax\n\t"
+        "cmpl %[num_cpus], %%eax\n\t"
+        "jae .Lvalloc_pop_commit%=\n\t"
+        "imulq %[stride], %%rax\n\t"
+        "addq %[base], %%rax\n\t"
+        "movl (%%rax), %%ecx\n\t"
+        "testl %%ecx, %%ecx\n\t"
+        "jz .Lvalloc_pop_commit%=\n\t"
+        "decl %%ecx\n\t"
+        "movq 8(%%rax, %%rcx, 8), %[ptr]\n\t"
+        "movl %%ecx, (%%rax)\n\t"
+        ".Lvalloc_pop_commit%=:\n\t"
+        : [ptr] "=&r"(ptr), [rseq_cs] "=m"(rs->rseq_cs)
+        : [cpu_id] "m"(rs->cpu_id), [num_cpus] "r"(num_cpus), [stride] "r"(stride), [base] "r"(base)
+        : "rax", "rcx", "memory", "cc");
+    return ptr;
+}
+
+/**
+ * @brief Empile un objet dans le cache du processeur courant
+ * 
+ * Section critique rseq : l'objet est écrit au-dessus du sommet, puis
+ * l'écriture de count le rend visible et valide l'opération.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param size_class Classe de taille
+ * @param ptr Objet libre
+ * @return bool false si la pile est pleine
+ */
+static inline bool cpu_cache_push(MemoryAllocator* allocator, size_t size_class, void* ptr) {
+    struct rseq* rs = rseq_area();
+    char* base = (char*)&allocator->cpu_caches[0].bins[size_class];
+    uint64_t stride = sizeof(CpuCache);
+    uint32_t num_cpus = (uint32_t)allocator->num_cpus;
+    uint32_t pushed;
+
+    __asm__ __volatile__(
+        ".pushsection __rseq_cs, \"aw\"\n\t"
+        ".balign 32\n\t"
+        ".Lvalloc_push_cs%=:\n\t"
+        ".long 0, 0\n\t"
+        ".quad .Lvalloc_push_start%=, .Lvalloc_push_commit%= - .Lvalloc_push_start%=, .Lvalloc_push_abort%=\n\t"
+        ".popsection\n\t"
+        ".pushsection __rseq_failure, \"ax\"\n\t"
+        ".byte 0x0f, 0xb9, 0x3d\n\t"
+        ".long 0x53053053\n\t"
+        ".Lvalloc_push_abort%=:\n\t"
+        "jmp .Lvalloc_push_retry%=\n\t"
+        ".popsection\n\t"
+        ".Lvalloc_push_retry%=:\n\t"
+        "xorl %[pushed], %[pushed]\n\t"
+        "leaq .Lvalloc_push_cs%=(%%rip), %%rax\n\t"
+        "movq %%rax, %[rseq_cs]\n\t"
+        ".Lvalloc_push_start%=:\n\t"
+        "movl %[cpu_id], %%eax\n\t"
+        "cmpl %[num_cpus], %%eax\n\t"
+        "jae .Lvalloc_push_commit%=\n\t"
+        "imulq %[stride], %%rax\n\t"
+        "addq %[base], %%rax\n\t"
+        "movl (%%rax), %%ecx\n\t"
+        "cmpl %[depth], %%ecx\n\t"
+        "jae .Lvalloc_push_commit%=\n\t"
+        "movq %[value], 8(%%rax, %%rcx, 8)\n\t"
+        "incl %%ecx\n\t"
+        "movl $1, %[pushed]\n\t"
+        "movl %%ecx, (%%rax)\n\t"
+        ".Lvalloc_push_commit%=:\n\t"
+        : [pushed] "=&r"(pushed), [rseq_cs] "=m"(rs->rseq_cs)
+        : [cpu_id] "m"(rs->cpu_id), [num_cpus] "r"(num_cpus), [stride] "r"(stride), [base] "r"(base),
+          [value] "r"(ptr), [depth] "i"(CPU_CACHE_DEPTH)
+        : "rax", "rcx", "memory", "cc");
+    return pushed != 0;
+}
+
+/**
+ * @brief Indique si les caches par processeur sont utilisables
+ * 
+ * @return bool true si la glibc a enregistré rseq pour le thread appelant
+ */
+static bool rseq_available(void) {
+    return __rseq_size >= 20 && (int)rseq_area()->cpu_id >= 0;
+}
+
+#else
+
+static inline CpuCache* cpu_cache_current(MemoryAllocator* allocator) {
+    (void)allocator;
+    return NULL;
+}
+
+static inline void* cpu_cache_pop(MemoryAllocator* allocator, size_t size_class) {
+    (void)allocator;
+    (void)size_class;
+    return NULL;
+}
+
+static inline bool cpu_cache_push(MemoryAllocator* allocator, size_t size_class, void* ptr) {
+    (void)allocator;
+    (void)size_class;
+    (void)ptr;
+    return false;
+}
+
+static bool rseq_available(void) {
+    return false;
+}
+
+#endif
+
+/**
+ * @brief Alloue un petit objet depuis le cache du processeur courant
+ * 
+ * Un échec prend, sous un seul verrouillage de la liste centrale, l'objet
+ * demandé et un lot d'une demi-pile, empilé ensuite hors verrou.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param cpu Cache du processeur (compteurs)
+ * @param size_class Classe de taille
+ * @return void* Objet alloué, NULL en cas d'échec
+ */
+static void* cpu_cache_alloc(MemoryAllocator* allocator, CpuCache* cpu, size_t size_class) {
+    void* ptr = cpu_cache_pop(allocator, size_class);
+    if (ptr) {
+        STAT_ADD(allocator, cpu, cache_hits, 1);
+        return ptr;
+    }
+    STAT_ADD(allocator, cpu, cache_misses, 1);
+
+    Arena* arena = thread_arena(allocator);
+    CacheBlock* list = NULL;
+    SlabClass* cls = class_lock(allocator, arena, size_class);
+    ptr = slab_alloc(allocator, arena, size_class, -1);
+    uint32_t taken = ptr ? slab_take(arena, size_class, -1, CPU_CACHE_DEPTH / 2, &list) : 0;
+    pthread_mutex_unlock(&cls->mutex);
+    if (taken == 0) return ptr;
+
+    // Le thread a pu changer de processeur : ce qui ne tient plus retourne aux spans
+    STAT_ADD(allocator, cpu, cache_refills, 1);
+    CacheBlock* overflow = NULL;
+    while (list) {
+        CacheBlock* block = list;
+        list = list->next;
+        if (!cpu_cache_push(allocator, size_class, block)) {
+            block->next = overflow;
+            overflow = block;
+        }
+    }
+    cache_release(allocator, overflow);
+    return ptr;
+}
+
+/**
+ * @brief Libère un petit objet dans le cache du processeur courant
+ * 
+ * Une pile pleine rend d'abord la moitié de ses objets aux listes centrales.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param cpu Cache du processeur (compteurs)
+ * @param ptr Objet libéré
+ * @param size_class Classe de taille
+ */
+static void cpu_cache_free(MemoryAllocator* allocator, CpuCache* cpu, void* ptr, size_t size_class) {
+    if (cpu_cache_push(allocator, size_class, ptr)) return;
+
+    CacheBlock* list = NULL;
+    for (int i = 0; i < CPU_CACHE_DEPTH / 2; i++) {
+        CacheBlock* block = (CacheBlock*)cpu_cache_pop(allocator, size_class);
+        if (block == NULL) break;
+        block->next = list;
+        list = block;
+    }
+    if (!cpu_cache_push(allocator, size_class, ptr)) {
+        CacheBlock* block = (CacheBlock*)ptr;
+        block->next = list;
+        list = block;
+    }
+
+    STAT_ADD(allocator, cpu, cache_flushes, 1);
+    cache_release(allocator, list);
+}
+
+/**
+ * @brief Rend aux listes centrales le cache du processeur courant
+ * 
+ * Les caches des autres processeurs ne peuvent être vidés que depuis
+ * ces processeurs.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ */
+static void cpu_cache_flush(MemoryAllocator* allocator) {
+    CacheBlock* list = NULL;
+    for (size_t c = 0; c < NUM_SIZE_CLASSES; c++) {
+        CacheBlock* block;
+        while ((block = (CacheBlock*)cpu_cache_pop(allocator, c)) != NULL) {
+            block->next = list;
+            list = block;
+        }
+    }
+    cache_release(allocator, list);
+}
+
+/**
+ * @brief Destructeur appelé à la terminaison d'un thread
+ * 
+ * Vide le cache du thread vers le pool global et le rend disponible
+ * pour le prochain thread qui s'enregistre.
+ * 
+ * @param arg Cache du thread qui se termine
+ */
+static void thread_cache_exit(void* arg) {
+    ThreadCache* cache = (ThreadCache*)arg;
+    MemoryAllocator* allocator = cache->allocator;
+
+    // Marqué avant le vidage : les libérations suivantes ne visent plus ce cache,
+    // celles déjà en vol sont reprises à sa réutilisation ou par valloc_cleanup
+    __atomic_store_n(&cache->dead, true, __ATOMIC_RELEASE);
+    cache_flush(allocator, cache);
+
+    global_lock(allocator);
+    cache->next_free = allocator->free_caches;
+    allocator->free_caches = cache;
+    pthread_mutex_unlock(&allocator->mutex);
+
+    if (tls_cache == cache) {
+        tls_allocator = NULL;
+        tls_cache = NULL;
+    }
+    // Les libérations qui suivent (autres destructeurs, libc) ne recréent pas de cache
+    tls_no_cache = true;
+}
+
+/**
+ * @brief Reprend les blocs en attente sur les caches des threads terminés
+ * 
+ * Libérations parties vers un cache juste avant que son thread ne le
+ * marque terminé : elles retournent aux listes centrales.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ */
+static void thread_cache_reclaim(MemoryAllocator* allocator) {
+    CacheBlock* list = NULL;
+
+    global_lock(allocator);
+    for (ThreadCache* cache = allocator->free_caches; cache; cache = cache->next_free) {
+        CacheBlock* pending = cache_take_remote(cache);
+        while (pending) {
+            CacheBlock* block = pending;
+            pending = block->next;
+            block->next = list;
+            list = block;
+        }
+    }
+    pthread_mutex_unlock(&allocator->mutex);
+
+    cache_release(allocator, list);
+}
+
+/**
+ * @brief Enregistre un cache pour le thread courant
+ * 
+ * Réutilise le cache d'un thread terminé s'il en existe, sinon attribue
+ * un nouvel indice en étendant le registre d'une tranche si nécessaire.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @return ThreadCache* Cache du thread, NULL en cas d'échec
+ */
+static ThreadCache* thread_cache_register(MemoryAllocator* allocator) {
+    global_lock(allocator);
+
+    ThreadCache* cache = allocator->free_caches;
+    if (cache) {
+        allocator->free_caches = cache->next_free;
+        cache->next_free = NULL;
+        cache_reset(allocator, cache);
+        // Blocs rendus après le vidage du thread terminé : aux listes centrales
+        __atomic_store_n(&cache->dead, false, __ATOMIC_RELEASE);
+        CacheBlock* pending = cache_take_remote(cache);
+        pthread_mutex_unlock(&allocator->mutex);
+        cache_release(allocator, pending);
+        return cache;
+    }
+
+    int index = allocator->num_threads;
+    if (index >= MAX_THREADS) {
+        pthread_mutex_unlock(&allocator->mutex);
+        return NULL;
+    }
+
+    ThreadCache** chunk = allocator->thread_caches[index >> CACHE_REGISTRY_CHUNK_SHIFT];
+    if (chunk == NULL) {
+        chunk = (ThreadCache**)meta_alloc(CACHE_REGISTRY_CHUNK_SIZE * sizeof(ThreadCache*));
+        if (chunk == NULL) {
+            pthread_mutex_unlock(&allocator->mutex);
+            return NULL;
+        }
+        __atomic_store_n(&allocator->thread_caches[index >> CACHE_REGISTRY_CHUNK_SHIFT], chunk,
+                         __ATOMIC_RELEASE);
+    }
+
+    cache = (ThreadCache*)meta_alloc(sizeof(ThreadCache));
+    if (cache == NULL) {
+        pthread_mutex_unlock(&allocator->mutex);
+        return NULL;
+    }
+    cache->allocator = allocator;
+    cache->index = index;
+    cache_reset(allocator, cache);
+    __atomic_store_n(&chunk[index & (CACHE_REGISTRY_CHUNK_SIZE - 1)], cache, __ATOMIC_RELEASE);
+    allocator->num_threads++;
+
+    pthread_mutex_unlock(&allocator->mutex);
+    return cache;
+}
+
+/**
+ * @brief Récupère le cache thread-local pour le thread courant
+ * 
+ * Chemin rapide : le dernier cache utilisé est mémorisé en TLS.
+ * Sinon, le cache est retrouvé via la clé de l'allocateur, ou
+ * enregistré lors du premier appel du thread.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @return ThreadCache* Pointeur vers le cache du thread, NULL si les caches sont désactivés
+ */
+ThreadCache* get_thread_cache(MemoryAllocator* allocator) {
+    if (tls_allocator == allocator && tls_epoch == allocator->epoch) return tls_cache;
+    if (!allocator->caches_enabled || tls_no_cache) return NULL;
+
+    ThreadCache* cache = (ThreadCache*)pthread_getspecific(allocator->cache_key);
+    if (cache == NULL) {
+        tls_no_cache = true;
+        cache = thread_cache_register(allocator);
+        int err = cache ? pthread_setspecific(allocator->cache_key, cache) : -1;
+        tls_no_cache = false;
+        if (cache == NULL) return NULL;
+        if (err != 0) {
+            thread_cache_exit(cache);
+            return NULL;
+        }
+    }
+
+    tls_allocator = allocator;
+    tls_epoch = allocator->epoch;
+    tls_cache = cache;
+    return cache;
+}
+
+/**
+ * @brief Nombre de nœuds NUMA du système
+ * 
+ * Lu dans /sys/devices/system/node/possible (par exemple "0-1") avec
+ * open/read : aucune allocation, utilisable au démarrage d'un LD_PRELOAD.
+ * 
+ * @return int Nombre de nœuds, 1 si la topologie est inconnue
+ */
+static int numa_system_nodes(void) {
+    int fd = open("/sys/devices/system/node/possible", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 1;
+
+    char buf[64];
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len <= 0) return 1;
+    buf[len] = '\0';
+
+    // Dernier nombre de la liste : nœud le plus élevé
+    int last = 0, value = 0;
+    for (ssize_t k = 0; k < len; k++) {
+        if (buf[k] >= '0' && buf[k] <= '9') {
+            value = value * 10 + (buf[k] - '0');
+            last = value;
+        } else {
+            value = 0;
+        }
+    }
+    return last + 1;
+}
+
+/**
+ * @brief Impose le nombre d'arènes NUMA
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param nodes Nombre d'arènes (1 à VALLOC_MAX_NODES)
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+int valloc_set_numa_nodes(MemoryAllocator* allocator, int nodes) {
+    if (allocator == NULL || !allocator->initialized || nodes < 1 || nodes > VALLOC_MAX_NODES) {
+        return -1;
+    }
+    allocator->num_arenas = nodes;
+    return 0;
+}
+
+/**
+ * @brief Impose le nœud NUMA du thread appelant
+ * 
+ * @param node Nœud simulé (-1 pour revenir à la détection)
+ */
+void valloc_set_thread_node(int node) {
+    tls_node = node < 0 ? -1 : node;
+}
+
+/**
+ * @brief Nœud NUMA de l'arène d'où provient un bloc
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Pointeur vers le bloc alloué
+ * @return int Nœud de l'arène, -1 si ptr n'a pas été alloué par l'allocateur
+ */
+int valloc_node_of(MemoryAllocator* allocator, const void* ptr) {
+    if (valloc_usable_size(allocator, ptr) == 0) return -1;
+    MemoryBlock* block = pagemap_get(allocator->page_map, ptr);
+    return allocator->arenas[block->arena].node;
+}
+
+/**
+ * @brief Initialise l'allocateur de mémoire
+ * 
+ * Alloue la première tranche de la table des blocs, les suivantes étant
+ * ajoutées à la demande.
+ * Initialise le mutex global et les caches des threads.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param initial_blocks Capacité initiale de la table des blocs (agrandie à la demande)
+ * @param num_threads Nombre de threads à supporter
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+int valloc_init(MemoryAllocator* allocator, size_t initial_blocks, int num_threads) {
+    return valloc_init_flags(allocator, initial_blocks, num_threads, 0);
+}
+
+/**
+ * @brief Initialise l'allocateur de mémoire avec des options
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param initial_blocks Capacité initiale de la table des blocs (agrandie à la demande)
+ * @param num_threads Nombre de threads à supporter
+ * @param flags Combinaison de VALLOC_HUGE_PAGES, VALLOC_HUGETLB, VALLOC_NUMA, VALLOC_PERCPU
+ *              et VALLOC_DEBUG_SIZED
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+int valloc_init_flags(MemoryAllocator* allocator, size_t initial_blocks, int num_threads, unsigned int flags) {
+    if (allocator == NULL || initial_blocks == 0 || num_threads < 0 || (flags & ~VALLOC_FLAGS_ALL) != 0) {
+        return -1;
+    }
+
+    // Table des blocs : la première tranche couvre initial_blocks emplacements,
+    // les suivantes sont ajoutées à la demande
+    size_t shift = BLOCK_TABLE_MIN_SHIFT;
+    while (((size_t)1 << shift) < initial_blocks) shift++;
+    memset(allocator->block_chunks, 0, sizeof(allocator->block_chunks));
+    allocator->block_chunk_shift = shift;
+    allocator->block_chunk_count = 0;
+    allocator->total_blocks = 0;
+    allocator->next_block = 0;
+    allocator->free_slots = NULL;
+    if (block_table_grow(allocator) != 0) {
+        return -1;
+    }
+
+    // Index adresse -> bloc
+    allocator->page_map = (PageMap*)meta_alloc(sizeof(PageMap));
+    if (allocator->page_map == NULL) {
+        meta_free(allocator->block_chunks[0], ((size_t)1 << shift) * sizeof(MemoryBlock));
+        return -1;
+    }
+
+    // Initialisation du mutex global
+    if (pthread_mutex_init(&allocator->mutex, NULL) != 0) {
+        pagemap_destroy(allocator->page_map);
+        meta_free(allocator->block_chunks[0], ((size_t)1 << shift) * sizeof(MemoryBlock));
+        return -1;
+    }
+
+    // Clé de terminaison des threads, pour vider leur cache
+    if (pthread_key_create(&allocator->cache_key, thread_cache_exit) != 0) {
+        pthread_mutex_destroy(&allocator->mutex);
+        pagemap_destroy(allocator->page_map);
+        meta_free(allocator->block_chunks[0], ((size_t)1 << shift) * sizeof(MemoryBlock));
+        return -1;
+    }
+
+    // Purge en arrière-plan, lancée par valloc_scavenger_start ; l'attente
+    // suit l'horloge monotone, insensible aux changements d'heure
+    Scavenger* scavenger = &allocator->scavenger;
+    memset(scavenger, 0, sizeof(*scavenger));
+    pthread_mutex_init(&scavenger->mutex, NULL);
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&scavenger->wakeup, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    // Profileur de tas, inactif jusqu'à valloc_profile_start
+    Profiler* profiler = &allocator->profiler;
+    memset(profiler, 0, sizeof(*profiler));
+    profiler->period = VALLOC_PROFILE_DEFAULT_PERIOD;
+    pthread_mutex_init(&profiler->mutex, NULL);
+    sem_init(&profiler->dump_request, 0, 0);
+    allocator->profiling = false;
+
+    // Arènes : toutes prêtes, pour que valloc_set_numa_nodes puisse en changer le nombre
+    for (int i = 0; i < VALLOC_MAX_NODES; i++) {
+        Arena* arena = &allocator->arenas[i];
+        memset(arena, 0, sizeof(*arena));
+        pthread_mutex_init(&arena->mutex, NULL);
+        for (size_t c = 0; c < NUM_SIZE_CLASSES; c++) {
+            pthread_mutex_init(&arena->classes[c].mutex, NULL);
+        }
+        arena->node = i;
+    }
+    allocator->system_nodes = numa_system_nodes();
+    allocator->num_arenas = 1;
+    if (flags & VALLOC_NUMA) {
+        allocator->num_arenas = allocator->system_nodes < VALLOC_MAX_NODES ? allocator->system_nodes
+                                                                           : VALLOC_MAX_NODES;
+    }
+
+    // Initialisation de l'état de l'allocateur
+    memset(&allocator->pool_stats, 0, sizeof(allocator->pool_stats));
+    memset(&allocator->shared_stats, 0, sizeof(allocator->shared_stats));
+    allocator->used_blocks = 0;
+    allocator->recycled_blocks = 0;
+    allocator->flags = flags;
+    allocator->initialized = true;
+
+    // Registre des caches des threads, rempli à la demande
+    memset(allocator->thread_caches, 0, sizeof(allocator->thread_caches));
+    allocator->num_threads = 0;
+    allocator->caches_enabled = num_threads > 0;
+
+    allocator->free_caches = NULL;
+    allocator->epoch = __atomic_add_fetch(&next_epoch, 1, __ATOMIC_RELAXED);
+    for (size_t c = 0; c < NUM_CACHE_CLASSES; c++) {
+        allocator->cache_depth[c] = c < NUM_SIZE_CLASSES ? MAX_CACHE_BLOCKS : MAX_CACHE_LARGE_BLOCKS;
+    }
+    allocator->large_cache_limit = VALLOC_LARGE_CACHE_DEFAULT;
+
+    // Caches par processeur : un par processeur possible, repli sur les
+    // caches thread-locaux si la glibc n'a pas enregistré rseq
+    allocator->cpu_caches = NULL;
+    allocator->num_cpus = 0;
+    if (flags & VALLOC_PERCPU) {
+        int num_cpus = get_nprocs_conf();
+        if (rseq_available() && num_cpus > 0) {
+            allocator->cpu_caches = (CpuCache*)meta_alloc((size_t)num_cpus * sizeof(CpuCache));
+        }
+        if (allocator->cpu_caches) {
+            allocator->num_cpus = num_cpus;
+        } else {
+            allocator->flags &= ~VALLOC_PERCPU;
+        }
+    }
+
+    return 0;
+}
+
+// Case d'un échantillon supprimé de la table du profileur
+#define PROFILE_TOMBSTONE ((void*)1)
+// Adresses de retour capturées en plus de la pile utile (cadres du profileur)
+#define PROFILE_SKIP_DEPTH 8
+
+/**
+ * @brief Logarithme népérien, sans dépendre de libm
+ * 
+ * Réduction à une mantisse de [1, 2), puis série de atanh : précision
+ * largement suffisante pour un tirage aléatoire.
+ * 
+ * @param x Valeur strictement positive
+ * @return double ln(x)
+ */
+static double profile_log(double x) {
+    int exponent = 0;
+    while (x >= 2.0) { x /= 2.0; exponent++; }
+    while (x < 1.0) { x *= 2.0; exponent--; }
+    double z = (x - 1.0) / (x + 1.0);
+    double z2 = z * z;
+    double series = z * (1.0 + z2 * (1.0 / 3 + z2 * (1.0 / 5 + z2 * (1.0 / 7 + z2 / 9))));
+    return exponent * 0.6931471805599453 + 2.0 * series;
+}
+
+/**
+ * @brief Calcule exp(-x), sans dépendre de libm
+ * 
+ * @param x Valeur positive
+ * @return double exp(-x)
+ */
+static double profile_exp_neg(double x) {
+    if (x > 64.0) return 0.0;
+    int squarings = 0;
+    while (x > 0.0625) { x /= 2.0; squarings++; }
+    double result = 1.0 - x * (1.0 - x / 2 * (1.0 - x / 3 * (1.0 - x / 4 * (1.0 - x / 5))));
+    while (squarings--) result *= result;
+    return result;
+}
+
+/**
+ * @brief Tire le nombre d'octets avant le prochain échantillon
+ * 
+ * Loi exponentielle de moyenne period : chaque octet alloué a la même
+ * probabilité d'être échantillonné, quelle que soit la taille des objets.
+ * 
+ * @param period Nombre moyen d'octets entre deux échantillons
+ * @return int64_t Octets avant le prochain échantillon
+ */
+static int64_t profile_next_interval(size_t period) {
+    // xorshift64*, 26 bits uniformes dans ]0, 1]
+    tls_sample_rng ^= tls_sample_rng >> 12;
+    tls_sample_rng ^= tls_sample_rng << 25;
+    tls_sample_rng ^= tls_sample_rng >> 27;
+    uint64_t q = ((tls_sample_rng * 2685821657736338717ULL) >> 38) + 1;
+    double u = (double)q / (double)(1 << 26);
+    return (int64_t)(-profile_log(u) * (double)period) + 1;
+}
+
+/**
+ * @brief Case de la table des échantillons où commencer à chercher ptr
+ * 
+ * @param profiler Profileur
+ * @param ptr Objet échantillonné
+ * @return size_t Indice de départ du sondage linéaire
+ */
+static size_t profile_slot(const Profiler* profiler, const void* ptr) {
+    uint64_t h = (uint64_t)(uintptr_t)ptr >> 4;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (size_t)h & (profiler->capacity - 1);
+}
+
+/**
+ * @brief Cherche l'échantillon d'un objet
+ * 
+ * Doit être appelée avec le mutex du profileur verrouillé.
+ * 
+ * @param profiler Profileur
+ * @param ptr Objet recherché
+ * @return ProfileSample* Échantillon, NULL si ptr n'est pas échantillonné
+ */
+static ProfileSample* profile_find(Profiler* profiler, const void* ptr) {
+    if (profiler->capacity == 0) return NULL;
+    for (size_t i = profile_slot(profiler, ptr);; i = (i + 1) & (profiler->capacity - 1)) {
+        ProfileSample* sample = &profiler->samples[i];
+        if (sample->ptr == ptr) return sample;
+        if (sample->ptr == NULL) return NULL;
+    }
+}
+
+/**
+ * @brief Insère un échantillon, en agrandissant la table si nécessaire
+ * 
+ * La table est prise à mmap et reconstruite sans les cases supprimées
+ * dès qu'elle est à moitié pleine.
+ * Doit être appelée avec le mutex du profileur verrouillé.
+ * 
+ * @param profiler Profileur
+ * @param sample Échantillon à copier
+ * @return int 0 en cas de succès, -1 si la table n'a pas pu être agrandie
+ */
+static int profile_insert(Profiler* profiler, const ProfileSample* sample) {
+    if ((profiler->used + 1) * 2 > profiler->capacity) {
+        size_t capacity = 256;
+        while (capacity < (profiler->count + 1) * 4) capacity *= 2;
+        ProfileSample* samples = (ProfileSample*)meta_alloc(capacity * sizeof(ProfileSample));
+        if (samples == NULL) return -1;
+
+        ProfileSample* old = profiler->samples;
+        size_t old_capacity = profiler->capacity;
+        profiler->samples = samples;
+        profiler->capacity = capacity;
+        profiler->used = profiler->count;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old[i].ptr == NULL || old[i].ptr == PROFILE_TOMBSTONE) continue;
+            size_t j = profile_slot(profiler, old[i].ptr);
+            while (samples[j].ptr != NULL) j = (j + 1) & (capacity - 1);
+            samples[j] = old[i];
+        }
+        meta_free(old, old_capacity * sizeof(ProfileSample));
+    }
+
+    size_t i = profile_slot(profiler, sample->ptr);
+    while (profiler->samples[i].ptr != NULL && profiler->samples[i].ptr != PROFILE_TOMBSTONE) {
+        i = (i + 1) & (profiler->capacity - 1);
+    }
+    if (profiler->samples[i].ptr == NULL) profiler->used++;
+    profiler->samples[i] = *sample;
+    profiler->count++;
+    return 0;
+}
+
+/**
+ * @brief Enregistre un objet échantillonné avec sa pile d'appels
+ * 
+ * La pile est tronquée à l'appelant de l'allocateur (caller), pour
+ * ne pas faire apparaître les cadres internes.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Objet alloué
+ * @param size Taille demandée
+ * @param caller Adresse de retour vers l'appelant de l'allocateur
+ */
+static __attribute__((noinline)) void profile_record(MemoryAllocator* allocator, void* ptr, size_t size, void* caller) {
+    void* stack[VALLOC_PROFILE_MAX_DEPTH + PROFILE_SKIP_DEPTH];
+    int depth = backtrace(stack, VALLOC_PROFILE_MAX_DEPTH + PROFILE_SKIP_DEPTH);
+    int first = 0;
+    while (first < depth && stack[first] != caller) first++;
+    if (first == depth) first = 0;
+
+    ProfileSample sample;
+    sample.ptr = ptr;
+    sample.size = size;
+    sample.depth = depth - first < VALLOC_PROFILE_MAX_DEPTH ? depth - first : VALLOC_PROFILE_MAX_DEPTH;
+    memcpy(sample.stack, stack + first, (size_t)sample.depth * sizeof(void*));
+
+    Profiler* profiler = &allocator->profiler;
+    pthread_mutex_lock(&profiler->mutex);
+    if (profile_insert(profiler, &sample) == 0) {
+        // Marque l'objet : seules ses libérations consultent la table
+        MemoryBlock* block = pagemap_get(allocator->page_map, ptr);
+        size_t index;
+        SlabSpan* span = block->slab ? slab_locate(block, ptr, &index) : NULL;
+        if (span) {
+            __atomic_add_fetch(&span->sampled, 1, __ATOMIC_RELAXED);
+        } else {
+            block->sampled = true;
+        }
+    }
+    pthread_mutex_unlock(&profiler->mutex);
+}
+
+/**
+ * @brief Décompte une allocation et l'échantillonne au terme de l'intervalle tiré
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Objet alloué (NULL en cas d'échec)
+ * @param size Taille demandée
+ * @param caller Adresse de retour vers l'appelant de l'allocateur
+ */
+static void profile_alloc(MemoryAllocator* allocator, void* ptr, size_t size, void* caller) {
+    size_t period = __atomic_load_n(&allocator->profiler.period, __ATOMIC_RELAXED);
+    if (tls_sample_rng == 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        tls_sample_rng = ((uint64_t)(uintptr_t)&tls_sample_rng * 0x9E3779B97F4A7C15ULL) ^
+                         ((uint64_t)ts.tv_nsec << 20) ^ (uint64_t)ts.tv_sec;
+        if (tls_sample_rng == 0) tls_sample_rng = 1;
+        tls_sample_left = profile_next_interval(period);
+    }
+
+    tls_sample_left -= (int64_t)size;
+    if (tls_sample_left >= 0) return;
+    tls_sample_left = profile_next_interval(period);
+    if (ptr == NULL || tls_in_profile) return;
+
+    tls_in_profile = true;
+    profile_record(allocator, ptr, size, caller);
+    tls_in_profile = false;
+}
+
+/**
+ * @brief Retire de la table l'échantillon d'un objet libéré
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Objet libéré
+ * @param block Bloc de la table contenant ptr
+ * @param span Span de l'objet (NULL pour un grand bloc)
+ */
+static void profile_free(MemoryAllocator* allocator, void* ptr, MemoryBlock* block, SlabSpan* span) {
+    Profiler* profiler = &allocator->profiler;
+    pthread_mutex_lock(&profiler->mutex);
+    ProfileSample* sample = profile_find(profiler, ptr);
+    if (sample) {
+        sample->ptr = PROFILE_TOMBSTONE;
+        profiler->count--;
+        if (span) {
+            __atomic_sub_fetch(&span->sampled, 1, __ATOMIC_RELAXED);
+        } else {
+            block->sampled = false;
+        }
+    }
+    pthread_mutex_unlock(&profiler->mutex);
+}
+
+/**
+ * @brief Suit un grand bloc échantillonné déplacé par mremap
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param old_ptr Ancienne adresse
+ * @param new_ptr Nouvelle adresse
+ */
+static void profile_move(MemoryAllocator* allocator, void* old_ptr, void* new_ptr) {
+    Profiler* profiler = &allocator->profiler;
+    pthread_mutex_lock(&profiler->mutex);
+    ProfileSample* sample = profile_find(profiler, old_ptr);
+    if (sample) {
+        ProfileSample moved = *sample;
+        sample->ptr = PROFILE_TOMBSTONE;
+        profiler->count--;
+        moved.ptr = new_ptr;
+        profile_insert(profiler, &moved);
+    }
+    pthread_mutex_unlock(&profiler->mutex);
+}
+
+/**
+ * @brief Projette un nouveau grand bloc et l'enregistre dans la table
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param arena Arène du thread appelant, dont le nœud reçoit la mémoire
+ * @param size Taille du bloc
+ * @param alignment Alignement demandé (puissance de 2)
+ * @param owner Indice du cache propriétaire (-1 sans cache)
+ * @return void* Bloc alloué, NULL en cas d'échec
+ */
+static void* large_alloc(MemoryAllocator* allocator, Arena* arena, size_t size, size_t alignment, int owner) {
+    // Grands blocs en grandes pages transparentes : alignés sur 2 MiB pour
+    // que le noyau puisse les couvrir entièrement
+    bool huge = (allocator->flags & (VALLOC_HUGE_PAGES | VALLOC_HUGETLB)) && size >= VALLOC_HUGE_PAGE_SIZE;
+    if (huge && alignment < VALLOC_HUGE_PAGE_SIZE) alignment = VALLOC_HUGE_PAGE_SIZE;
+
+    void* ptr = map_aligned(allocator, size, alignment);
+    if (ptr == NULL) return NULL;
+    if (huge) madvise(ptr, size, MADV_HUGEPAGE);
+    arena_bind(allocator, arena, ptr, size);
+
+    // Enregistrement dans la table et dans l'index
+    MemoryBlock* block = block_register(allocator, ptr, size, false, arena);
+    if (block == NULL) {
+        pool_unmap(allocator, ptr, size);
+        return NULL;
+    }
+    block->owner = owner;
+    return ptr;
+}
+
+/**
+ * @brief Alloue un bloc de mémoire, sans échantillonnage
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur (initialisé)
+ * @param size Taille du bloc de mémoire nécessaire (non nulle)
+ * @return void* Pointeur vers le bloc de mémoire alloué, NULL en cas d'échec
+ */
+static void* block_alloc(MemoryAllocator* allocator, size_t size) {
+    // Les petits objets sont servis par classe de taille
+    size_t requested = size;
+    size_t size_class = NUM_SIZE_CLASSES;
+    if (size <= SLAB_MAX_SIZE) {
+        size_class = size_class_index(size);
+        size = size_class_size(size_class);
+    } else if (size > CACHE_MAX_SIZE) {
+        // Grands blocs : arrondis à la page, la granularité de leurs projections
+        const size_t page = (size_t)1 << VALLOC_PAGE_SHIFT;
+        size = (size + page - 1) & ~(page - 1);
+    }
+
+    // Petits objets d'un thread enregistré auprès de rseq : cache du processeur.
+    // Ses grands blocs passent directement par l'arène, sans cache de thread.
+    CpuCache* cpu = cpu_cache_current(allocator);
+    if (cpu && size_class < NUM_SIZE_CLASSES) {
+        STAT_ADD(allocator, cpu, allocs[size_class], 1);
+        STAT_ADD(allocator, cpu, bytes_requested, requested);
+        STAT_ADD(allocator, cpu, bytes_allocated, size);
+        return cpu_cache_alloc(allocator, cpu, size_class);
+    }
+
+    ThreadCache* cache = cpu ? NULL : get_thread_cache(allocator);
+    size_t stats_class = size_class < NUM_SIZE_CLASSES ? size_class : cache_class_index(size);
+    STAT_ADD(allocator, cache, allocs[stats_class], 1);
+    STAT_ADD(allocator, cache, bytes_requested, requested);
+    STAT_ADD(allocator, cache, bytes_allocated, size);
+
+    // Chemin rapide : essai du cache thread-local d'abord, après
+    // récupération des blocs rendus par les autres threads
+    if (cache) {
+        if (__atomic_load_n(&cache->remote, __ATOMIC_RELAXED)) {
+            cache_drain_remote(allocator, cache);
+        }
+        void* ptr = cache_allocate(cache, size);
+        if (ptr) {
+            STAT_ADD(allocator, cache, cache_hits, 1);
+            return ptr;
+        }
+        STAT_ADD(allocator, cache, cache_misses, 1);
+    }
+
+    // Chemin lent : arène du nœud du thread, liste centrale de la classe
+    // pour les petits objets
+    Arena* arena = thread_arena(allocator);
+    int owner = cache ? cache->index : -1;
+
+    if (size_class < NUM_SIZE_CLASSES) {
+        SlabClass* cls = class_lock(allocator, arena, size_class);
+        void* ptr = slab_alloc(allocator, arena, size_class, owner);
+        if (ptr && cache) cache_refill(allocator, cache, arena, size_class);
+        pthread_mutex_unlock(&cls->mutex);
+        return ptr;
+    }
+
+    arena_lock(allocator, arena);
+    // Recherche d'abord un bloc recyclé dans les classes de taille,
+    // ajusté à la demande
+    MemoryBlock* recycled = large_reuse(allocator, arena, size);
+    if (recycled) {
+        recycled->status = false;
+        recycled->recycled = false;
+        recycled->owner = owner;
+        __atomic_add_fetch(&allocator->used_blocks, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&allocator->recycled_blocks, 1, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&arena->mutex);
+        return recycled->adress;
+    }
+    pthread_mutex_unlock(&arena->mutex);
+
+    // Allocation de nouvelle mémoire si aucun bloc recyclé disponible
+    return large_alloc(allocator, arena, size, 0, owner);
+}
+
+/**
+ * @brief Alloue un bloc de mémoire
+ * 
+ * Tente d'abord d'allouer depuis le cache thread-local.
+ * Les petites tailles sont arrondies à leur classe et servies par les slabs.
+ * Pour les autres, recherche un bloc recyclé dans le pool global,
+ * puis alloue de la nouvelle mémoire si aucun n'est disponible.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param size Taille du bloc de mémoire nécessaire
+ * @return void* Pointeur vers le bloc de mémoire alloué, NULL en cas d'échec
+ */
+void* valloc_block(MemoryAllocator* allocator, size_t size) {
+    if (allocator == NULL || !allocator->initialized || size == 0) {
+        return NULL;
+    }
+
+    void* ptr = block_alloc(allocator, size);
+    if (__builtin_expect(allocator->profiling, 0)) {
+        profile_alloc(allocator, ptr, size, __builtin_return_address(0));
+    }
+    return ptr;
+}
+
+/**
+ * @brief Alloue un lot de blocs de même taille
+ * 
+ * Les petits objets sont pris dans le cache du thread (ou du processeur),
+ * puis le reste dans les spans partielles de la classe sous un seul
+ * verrou ; une span n'est créée que lorsqu'elles sont épuisées.
+ * Les grands blocs sont alloués un par un.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param size Taille de chaque bloc
+ * @param n Nombre de blocs demandés
+ * @param out_ptrs Tableau de n pointeurs, rempli par les blocs alloués
+ * @return size_t Nombre de blocs alloués (moins de n en cas d'échec)
+ */
+size_t valloc_batch(MemoryAllocator* allocator, size_t size, size_t n, void** out_ptrs) {
+    if (allocator == NULL || !allocator->initialized || size == 0 || out_ptrs == NULL) {
+        return 0;
+    }
+
+    void* caller = __builtin_return_address(0);
+    size_t done = 0;
+    if (size > SLAB_MAX_SIZE) {
+        while (done < n && (out_ptrs[done] = block_alloc(allocator, size)) != NULL) done++;
+    } else {
+        size_t size_class = size_class_index(size);
+        CpuCache* cpu = cpu_cache_current(allocator);
+        ThreadCache* cache = cpu ? NULL : get_thread_cache(allocator);
+
+        // Cache local d'abord, sans verrou
+        if (cpu) {
+            while (done < n && (out_ptrs[done] = cpu_cache_pop(allocator, size_class)) != NULL) done++;
+        } else if (cache) {
+            if (__atomic_load_n(&cache->remote, __ATOMIC_RELAXED)) {
+                cache_drain_remote(allocator, cache);
+            }
+            CacheBin* bin = &cache->bins[size_class];
+            while (done < n && bin->head) out_ptrs[done++] = cache_bin_pop(bin);
+        }
+        size_t hits = done;
+
+        // Le reste depuis la liste centrale de la classe, en un seul verrouillage
+        if (done < n) {
+            Arena* arena = thread_arena(allocator);
+            int owner = cache ? cache->index : -1;
+            SlabClass* cls = class_lock(allocator, arena, size_class);
+            while (done < n) {
+                CacheBlock* list = NULL;
+                size_t want = n - done < UINT32_MAX ? n - done : UINT32_MAX;
+                slab_take(arena, size_class, owner, (uint32_t)want, &list);
+                for (; list; list = list->next) out_ptrs[done++] = list;
+                if (done == n) break;
+
+                // Spans partielles épuisées : une nouvelle span sert la suite
+                void* ptr = slab_alloc(allocator, arena, size_class, owner);
+                if (ptr == NULL) break;
+                out_ptrs[done++] = ptr;
+            }
+            pthread_mutex_unlock(&cls->mutex);
+        }
+
+        if (cpu) {
+            STAT_ADD(allocator, cpu, allocs[size_class], done);
+            STAT_ADD(allocator, cpu, cache_hits, hits);
+            STAT_ADD(allocator, cpu, cache_misses, done - hits);
+            STAT_ADD(allocator, cpu, bytes_requested, size * done);
+            STAT_ADD(allocator, cpu, bytes_allocated, size_class_size(size_class) * done);
+        } else {
+            STAT_ADD(allocator, cache, allocs[size_class], done);
+            STAT_ADD(allocator, cache, bytes_requested, size * done);
+            STAT_ADD(allocator, cache, bytes_allocated, size_class_size(size_class) * done);
+            if (cache) {
+                STAT_ADD(allocator, cache, cache_hits, hits);
+                STAT_ADD(allocator, cache, cache_misses, done - hits);
+            }
+        }
+    }
+
+    if (__builtin_expect(allocator->profiling, 0)) {
+        for (size_t i = 0; i < done; i++) profile_alloc(allocator, out_ptrs[i], size, caller);
+    }
+    return done;
+}
+
+/**
+ * @brief Alloue un bloc de mémoire aligné
+ * 
+ * Les objets d'une span sont placés à des multiples de leur taille depuis
+ * un début de span aligné sur 64 KiB : un petit objet est donc servi par la
+ * plus petite classe dont la taille est multiple de l'alignement, et reste
+ * groupé avec les autres objets de sa classe. Les grands blocs sont alignés
+ * sur une page par mmap ; au-delà, leur projection est découpée à l'alignement.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param size Taille du bloc à allouer
+ * @param alignment Alignement demandé (puissance de 2, au plus VALLOC_MAX_ALIGNMENT)
+ * @return void* Pointeur vers le bloc aligné, NULL en cas d'échec
+ */
+void* valloc_aligned(MemoryAllocator* allocator, size_t size, size_t alignment) {
+    if (allocator == NULL || !allocator->initialized || size == 0) {
+        return NULL;
+    }
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment > VALLOC_MAX_ALIGNMENT) {
+        return NULL;
+    }
+
+    // Tous les blocs sont alignés sur 16 octets
+    if (alignment <= 16) return valloc_block(allocator, size);
+
+    if (size <= SLAB_MAX_SIZE && alignment <= SLAB_MAX_SIZE) {
+        size_t size_class = size_class_index(size);
+        while (size_class_size(size_class) % alignment != 0) size_class++;
+        return valloc_block(allocator, size_class_size(size_class));
+    }
+
+    // Grands blocs : mmap, les blocs recyclés et les caches alignent sur une page
+    const size_t page = (size_t)1 << VALLOC_PAGE_SHIFT;
+    if (size <= SLAB_MAX_SIZE) size = SLAB_MAX_SIZE + 1;
+    if (alignment <= page) return valloc_block(allocator, size);
+
+    ThreadCache* cache = cpu_cache_current(allocator) ? NULL : get_thread_cache(allocator);
+    STAT_ADD(allocator, cache, allocs[cache_class_index(size)], 1);
+    STAT_ADD(allocator, cache, bytes_requested, size);
+    STAT_ADD(allocator, cache, bytes_allocated, size);
+    void* ptr = large_alloc(allocator, thread_arena(allocator), size, alignment, cache ? cache->index : -1);
+    if (__builtin_expect(allocator->profiling, 0)) {
+        profile_alloc(allocator, ptr, size, __builtin_return_address(0));
+    }
+    return ptr;
+}
+
+/**
+ * @brief Rend un bloc alloué par un autre thread à son propriétaire
+ * 
+ * Sans verrou, pour que la mémoire ne migre pas vers les threads qui
+ * libèrent. Le bloc retourne aux listes centrales si le propriétaire est
+ * terminé (son cache ne serait plus vidé) ou s'il a déjà
+ * MAX_REMOTE_BLOCKS blocs en attente (il n'alloue peut-être plus).
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param cache Cache du thread appelant (NULL accepté)
+ * @param owner Indice du cache propriétaire
+ * @param ptr Pointeur vers le bloc
+ * @param size Taille du bloc
+ * @param central Lot destiné aux listes centrales, ou NULL pour y rendre le bloc immédiatement
+ * @return true si le bloc a été rendu, false si le propriétaire est inconnu
+ */
+static bool owner_free(MemoryAllocator* allocator, ThreadCache* cache, int owner, void* ptr, size_t size,
+                       CacheBlock** central) {
+    ThreadCache* owner_cache = thread_cache_at(allocator, owner);
+    if (owner_cache == NULL) return false;
+
+    if (__atomic_load_n(&owner_cache->dead, __ATOMIC_ACQUIRE) ||
+        __atomic_load_n(&owner_cache->remote_count, __ATOMIC_RELAXED) >= MAX_REMOTE_BLOCKS) {
+        CacheBlock* node = (CacheBlock*)ptr;
+        node->size = size;
+        if (central) {
+            node->next = *central;
+            *central = node;
+        } else {
+            node->next = NULL;
+            cache_release(allocator, node);
+        }
+        return true;
+    }
+    STAT_ADD(allocator, cache, remote_frees, 1);
+    cache_free_remote(owner_cache, ptr, size);
+    return true;
+}
+
+/**
+ * @brief Libère un bloc de mémoire
+ * 
+ * Un bloc alloué par un autre thread est rendu à ce thread via son canal
+ * distant. Sinon, met le bloc en cache, sans prendre de verrou ; un cache
+ * plein rend d'abord la moitié de sa liste aux spans et aux classes de
+ * recyclage. Au-delà de CACHE_MAX_SIZE, le bloc reste projeté dans le
+ * cache des grandes projections de son arène, dans la limite fixée par
+ * valloc_set_large_cache. Sans cache, le bloc retourne à sa span ou au système.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Pointeur vers le bloc de mémoire à libérer
+ */
+void free_valloc(MemoryAllocator* allocator, void* ptr) {
+    if (allocator == NULL || !allocator->initialized || ptr == NULL) {
+        return;
+    }
+
+    // Recherche du bloc via l'index, en temps constant et sans verrou
+    MemoryBlock* block = pagemap_get(allocator->page_map, ptr);
+    if (block == NULL) return;
+
+    size_t size;
+    int owner;
+    if (block->slab) {
+        size_t index;
+        SlabSpan* span = slab_locate(block, ptr, &index);
+        if (span == NULL) return;
+        size = span->object_size;
+        owner = __atomic_load_n(&span->owner, __ATOMIC_RELAXED);
+        if (__builtin_expect(__atomic_load_n(&span->sampled, __ATOMIC_RELAXED) != 0, 0)) {
+            profile_free(allocator, ptr, block, span);
+        }
+    } else {
+        if (block->adress != ptr || block->status) return;
+        size = block->size;
+        owner = block->owner;
+        if (__builtin_expect(block->sampled, 0)) profile_free(allocator, ptr, block, NULL);
+    }
+
+    // Caches par processeur : les petits objets y retournent, quel que soit
+    // le thread qui les a alloués ; les grands blocs sont recyclés dans leur arène
+    CpuCache* cpu = cpu_cache_current(allocator);
+    if (cpu) {
+        STAT_ADD(allocator, cpu, frees, 1);
+        if (block->slab) {
+            cpu_cache_free(allocator, cpu, ptr, size_class_index(size));
+        } else {
+            recycle_block(allocator, block, ptr);
+        }
+        return;
+    }
+
+    // Bloc alloué par un autre thread : rendu à son propriétaire, sans verrou,
+    // pour que la mémoire ne migre pas vers les threads qui libèrent
+    ThreadCache* cache = get_thread_cache(allocator);
+    STAT_ADD(allocator, cache, frees, 1);
+    if (owner >= 0 && (cache == NULL || owner != cache->index) && size <= CACHE_MAX_SIZE &&
+        owner_free(allocator, cache, owner, ptr, size, NULL)) {
+        return;
+    }
+
+    // Tente d'abord de mettre en cache le bloc ; un bloc en cache
+    // reste enregistré dans la table et n'est pas considéré comme libre.
+    // Cache plein : la moitié de la liste retourne aux listes centrales.
+    if (cache && size <= CACHE_MAX_SIZE) {
+        if (!cache_free(cache, ptr, size)) cache_overflow(allocator, cache, ptr, size);
+        return;
+    }
+
+    // Grands blocs : cache des projections de l'arène
+    if (!block->slab && size > CACHE_MAX_SIZE) {
+        recycle_block(allocator, block, ptr);
+        return;
+    }
+    pool_free(allocator, block, ptr);
+}
+
+/**
+ * @brief Libère un lot de blocs
+ * 
+ * Un seul parcours : chaque bloc va au cache du thread (ou du processeur),
+ * ou au cache de son propriétaire ; ceux qui n'y tiennent pas sont rendus
+ * aux listes centrales en un lot, un verrou par classe ou par arène
+ * concernée. Les grands blocs suivent le chemin de free_valloc.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptrs Blocs à libérer (les pointeurs NULL sont ignorés)
+ * @param n Nombre de pointeurs
+ */
+void free_valloc_batch(MemoryAllocator* allocator, void** ptrs, size_t n) {
+    if (allocator == NULL || !allocator->initialized || ptrs == NULL) {
+        return;
+    }
+
+    CpuCache* cpu = cpu_cache_current(allocator);
+    ThreadCache* cache = cpu ? NULL : get_thread_cache(allocator);
+    CacheBlock* list = NULL;
+    uint64_t frees = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        void* ptr = ptrs[i];
+        if (ptr == NULL) continue;
+        MemoryBlock* block = pagemap_get(allocator->page_map, ptr);
+        if (block == NULL) continue;
+
+        size_t size;
+        int owner;
+        if (block->slab) {
+            size_t index;
+            SlabSpan* span = slab_locate(block, ptr, &index);
+            if (span == NULL) continue;
+            size = span->object_size;
+            owner = __atomic_load_n(&span->owner, __ATOMIC_RELAXED);
+            if (__builtin_expect(__atomic_load_n(&span->sampled, __ATOMIC_RELAXED) != 0, 0)) {
+                profile_free(allocator, ptr, block, span);
+            }
+        } else {
+            if (block->adress != ptr || block->status) continue;
+            size = block->size;
+            owner = block->owner;
+            if (__builtin_expect(block->sampled, 0)) profile_free(allocator, ptr, block, NULL);
+        }
+        frees++;
+
+        // Grands blocs, et blocs dédiés sans cache : comme free_valloc
+        if (!block->slab && size > CACHE_MAX_SIZE) {
+            recycle_block(allocator, block, ptr);
+            continue;
+        }
+        if (!block->slab && cache == NULL && cpu == NULL) {
+            pool_free(allocator, block, ptr);
+            continue;
+        }
+
+        if (cpu) {
+            if (block->slab && cpu_cache_push(allocator, size_class_index(size), ptr)) continue;
+        } else {
+            if (owner >= 0 && (cache == NULL || owner != cache->index) &&
+                owner_free(allocator, cache, owner, ptr, size, &list)) {
+                continue;
+            }
+            if (cache && cache_free(cache, ptr, size)) continue;
+        }
+
+        CacheBlock* node = (CacheBlock*)ptr;
+        node->size = size;
+        node->next = list;
+        list = node;
+    }
+
+    if (cpu) {
+        STAT_ADD(allocator, cpu, frees, frees);
+        if (list) STAT_ADD(allocator, cpu, cache_flushes, 1);
+    } else {
+        STAT_ADD(allocator, cache, frees, frees);
+        if (list && cache) STAT_ADD(allocator, cache, cache_flushes, 1);
+    }
+    cache_release(allocator, list);
+}
+
+/**
+ * @brief Vérifie la taille annoncée à free_valloc_sized (VALLOC_DEBUG_SIZED)
+ * 
+ * La classe de size doit être celle de l'objet, sauf pour un objet réduit
+ * en place par valloc_realloc, qui garde sa classe tant que size dépasse
+ * la moitié de l'objet. Un objet de valloc_aligned dont la classe a été
+ * arrondie ne se distingue pas d'une taille erronée : il est annoncé avec
+ * sa taille utilisable.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Pointeur libéré
+ * @param size Taille annoncée
+ * @return true si ptr est un objet de slab compatible avec size
+ */
+static bool sized_check(MemoryAllocator* allocator, const void* ptr, size_t size) {
+    MemoryBlock* block = pagemap_get(allocator->page_map, ptr);
+    if (block == NULL || !block->slab) return false;
+    size_t index;
+    SlabSpan* span = slab_locate(block, ptr, &index);
+    if (span == NULL) return false;
+    return size_class_index(size) == span->size_class ||
+           (size <= span->object_size && size > span->object_size / 2);
+}
+
+/**
+ * @brief Libère un petit objet dont la taille est connue
+ * 
+ * Une taille d'au plus SLAB_MAX_SIZE désigne un objet de slab : sa span se
+ * déduit de l'adresse (chunks alignés sur leur taille), sans la table des
+ * blocs ni la division qui valide l'objet. La span reste lue, pour le
+ * propriétaire de l'objet et sa classe réelle (valloc_realloc garde un
+ * objet réduit en place dans sa classe). Les grands blocs n'ont de
+ * métadonnées que dans la table : ils passent par free_valloc.
+ * Avec VALLOC_DEBUG_SIZED, une taille incompatible avec l'objet est
+ * comptée et le bloc libéré par free_valloc.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Pointeur vers le bloc à libérer
+ * @param size Taille demandée à l'allocation (ou au dernier valloc_realloc)
+ */
+void free_valloc_sized(MemoryAllocator* allocator, void* ptr, size_t size) {
+    if (allocator == NULL || !allocator->initialized || ptr == NULL) {
+        return;
+    }
+    if (size == 0 || size > SLAB_MAX_SIZE) {
+        free_valloc(allocator, ptr);
+        return;
+    }
+    if (__builtin_expect(allocator->flags & VALLOC_DEBUG_SIZED, 0) && !sized_check(allocator, ptr, size)) {
+        __atomic_add_fetch(&allocator->pool_stats.sized_mismatches, 1, __ATOMIC_RELAXED);
+        free_valloc(allocator, ptr);
+        return;
+    }
+
+    SlabChunk* chunk = (SlabChunk*)((uintptr_t)ptr & ~(uintptr_t)(SLAB_CHUNK_SIZE - 1));
+    SlabSpan* span = &chunk->spans[((uintptr_t)ptr & (SLAB_CHUNK_SIZE - 1)) >> SLAB_SPAN_SHIFT];
+    size_t size_class = span->size_class;
+    size_t object_size = span->object_size;
+    int owner = __atomic_load_n(&span->owner, __ATOMIC_RELAXED);
+    if (__builtin_expect(__atomic_load_n(&span->sampled, __ATOMIC_RELAXED) != 0, 0)) {
+        profile_free(allocator, ptr, chunk->block, span);
+    }
+
+    CpuCache* cpu = cpu_cache_current(allocator);
+    if (cpu) {
+        STAT_ADD(allocator, cpu, frees, 1);
+        cpu_cache_free(allocator, cpu, ptr, size_class);
+        return;
+    }
+
+    ThreadCache* cache = get_thread_cache(allocator);
+    STAT_ADD(allocator, cache, frees, 1);
+    if (owner >= 0 && (cache == NULL || owner != cache->index) &&
+        owner_free(allocator, cache, owner, ptr, object_size, NULL)) {
+        return;
+    }
+    if (cache == NULL) {
+        pool_free(allocator, chunk->block, ptr);
+        return;
+    }
+    if (!cache_free(cache, ptr, object_size)) cache_overflow(allocator, cache, ptr, object_size);
+}
+
+/**
+ * @brief Taille réellement utilisable d'un bloc alloué
+ * 
+ * Lecture sans verrou, comme la recherche de free_valloc.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Pointeur vers le bloc alloué
+ * @return size_t Taille utilisable, 0 si ptr n'a pas été alloué par l'allocateur
+ */
+size_t valloc_usable_size(MemoryAllocator* allocator, const void* ptr) {
+    if (allocator == NULL || !allocator->initialized || ptr == NULL) {
+        return 0;
+    }
+
+    MemoryBlock* block = pagemap_get(allocator->page_map, ptr);
+    if (block == NULL) return 0;
+
+    if (block->slab) {
+        size_t index;
+        SlabSpan* span = slab_locate(block, ptr, &index);
+        return span ? span->object_size : 0;
+    }
+    return block->adress == ptr && !block->status ? block->size : 0;
+}
+
+/**
+ * @brief Déplace un bloc vers une nouvelle allocation
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Bloc actuel
+ * @param old_size Taille utilisable du bloc actuel
+ * @param size Nouvelle taille
+ * @return void* Nouveau bloc, NULL en cas d'échec (ptr reste valide)
+ */
+static void* realloc_move(MemoryAllocator* allocator, void* ptr, size_t old_size, size_t size) {
+    void* new_ptr = valloc_block(allocator, size);
+    if (new_ptr == NULL) return NULL;
+    memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+    free_valloc(allocator, ptr);
+    return new_ptr;
+}
+
+/**
+ * @brief Redimensionne un bloc alloué
+ * 
+ * Un petit objet reste en place tant que la nouvelle taille tient dans
+ * son objet sans en gaspiller plus de la moitié. Un grand bloc est réduit
+ * en place (les pages libérées en fin de projection sont rendues au système)
+ * et agrandi par mremap, sans copie, même s'il doit être déplacé.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Bloc à redimensionner (NULL : équivaut à valloc_block)
+ * @param size Nouvelle taille (0 : équivaut à free_valloc)
+ * @return void* Bloc redimensionné, NULL en cas d'échec (ptr reste alors valide)
+ */
+void* valloc_realloc(MemoryAllocator* allocator, void* ptr, size_t size) {
+    if (allocator == NULL || !allocator->initialized) {
+        return NULL;
+    }
+    if (ptr == NULL) return valloc_block(allocator, size);
+    if (size == 0) {
+        free_valloc(allocator, ptr);
+        return NULL;
+    }
+
+    MemoryBlock* block = pagemap_get(allocator->page_map, ptr);
+    if (block == NULL) return NULL;
+
+    // Petit objet : en place si la nouvelle taille tient dans l'objet
+    if (block->slab) {
+        size_t index;
+        SlabSpan* span = slab_locate(block, ptr, &index);
+        if (span == NULL) return NULL;
+        size_t old_size = span->object_size;
+        if (size <= old_size && size > old_size / 2) return ptr;
+        return realloc_move(allocator, ptr, old_size, size);
+    }
+
+    if (block->adress != ptr || block->status) return NULL;
+
+    // Grand bloc redevenu petit : servi par les slabs
+    if (size <= SLAB_MAX_SIZE) {
+        return realloc_move(allocator, ptr, block->size, size);
+    }
+
+    const size_t page = (size_t)1 << VALLOC_PAGE_SHIFT;
+    size_t old_mapped = (block->size + page - 1) & ~(page - 1);
+    size_t new_mapped = (size + page - 1) & ~(page - 1);
+
+    global_lock(allocator);
+
+    if (new_mapped <= old_mapped) {
+        // Réduction en place : les pages en trop sont rendues au système
+        if (new_mapped < old_mapped) {
+            pool_unmap(allocator, (char*)ptr + new_mapped, old_mapped - new_mapped);
+        }
+        block->size = new_mapped;
+        pthread_mutex_unlock(&allocator->mutex);
+        return ptr;
+    }
+
+    // Agrandissement : le noyau étend la projection ou la déplace, sans copie
+    void* new_ptr = mremap(ptr, old_mapped, new_mapped, MREMAP_MAYMOVE);
+    __atomic_add_fetch(&allocator->pool_stats.mremap_calls, 1, __ATOMIC_RELAXED);
+    if (new_ptr == MAP_FAILED) {
+        pthread_mutex_unlock(&allocator->mutex);
+        return realloc_move(allocator, ptr, block->size, size);
+    }
+    if (new_ptr != ptr) {
+        if (pagemap_set(allocator->page_map, new_ptr, block) != 0) {
+            // Index plein : la projection revient à sa place d'origine
+            void* back = mremap(new_ptr, new_mapped, old_mapped, MREMAP_MAYMOVE | MREMAP_FIXED, ptr);
+            (void)back;
+            pthread_mutex_unlock(&allocator->mutex);
+            return NULL;
+        }
+        pagemap_set(allocator->page_map, ptr, NULL);
+        block->adress = new_ptr;
+        if (block->sampled) profile_move(allocator, ptr, new_ptr);
+    }
+    stat_mapped(allocator, new_mapped - old_mapped);
+    block->size = new_mapped;
+    pthread_mutex_unlock(&allocator->mutex);
+    return new_ptr;
+}
+
+/**
+ * @brief Recycle un bloc de mémoire
+ * 
+ * Marque le bloc comme recyclé et disponible pour réutilisation.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Pointeur vers le bloc de mémoire à recycler
+ */
+void revalloc(MemoryAllocator* allocator, void* ptr) {
+    if (allocator == NULL || !allocator->initialized || ptr == NULL) {
+        return;
+    }
+
+    MemoryBlock* block = pagemap_get(allocator->page_map, ptr);
+    if (block == NULL) return;
+    __atomic_add_fetch(&allocator->shared_stats.frees, 1, __ATOMIC_RELAXED);
+
+    // Un petit objet recyclé retourne directement à sa span
+    if (block->slab) {
+        size_t index;
+        SlabSpan* span = slab_locate(block, ptr, &index);
+        if (span && __atomic_load_n(&span->sampled, __ATOMIC_RELAXED) != 0) {
+            profile_free(allocator, ptr, block, span);
+        }
+        pool_free(allocator, block, ptr);
+    } else {
+        if (block->sampled && block->adress == ptr) profile_free(allocator, ptr, block, NULL);
+        recycle_block(allocator, block, ptr);
+    }
+}
+
+/**
+ * @brief Nettoie l'allocateur
+ * 
+ * Vide le cache du thread appelant et celui de son processeur, puis libère
+ * tous les blocs recyclés et les spans vides.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ */
+void valloc_cleanup(MemoryAllocator* allocator) {
+    if (allocator == NULL || !allocator->initialized) {
+        return;
+    }
+
+    // Cache du processeur courant et cache du thread appelant (objets pris
+    // par lots compris) : seul leur propriétaire peut les vider
+    if (cpu_cache_current(allocator)) cpu_cache_flush(allocator);
+    if (allocator->caches_enabled) {
+        ThreadCache* cache = (ThreadCache*)pthread_getspecific(allocator->cache_key);
+        if (cache) cache_flush(allocator, cache);
+        thread_cache_reclaim(allocator);
+    }
+
+    for (int i = 0; i < VALLOC_MAX_NODES; i++) {
+        Arena* arena = &allocator->arenas[i];
+        arena_lock(allocator, arena);
+
+        // Parcours des seules classes non vides
+        for (size_t bin = recycle_bin_next(arena, 0); bin < NUM_RECYCLE_BINS;
+             bin = recycle_bin_next(arena, bin + 1)) {
+            while (arena->recycled_bins[bin]) {
+                MemoryBlock* block = arena->recycled_bins[bin];
+                recycle_bin_remove(arena, block);
+                pool_unmap(allocator, block->adress, block->size);
+                block_unregister(allocator, block);
+                __atomic_sub_fetch(&allocator->recycled_blocks, 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        pthread_mutex_unlock(&arena->mutex);
+
+        // Spans vides conservées comme dernière span de leur classe
+        for (size_t c = 0; c < NUM_SIZE_CLASSES; c++) {
+            SlabClass* cls = class_lock(allocator, arena, c);
+            SlabSpan* span = cls->partial;
+            if (span && span->next == NULL && span->free_count == span->capacity) {
+                slab_span_release(allocator, arena, span);
+            }
+            pthread_mutex_unlock(&cls->mutex);
+        }
+    }
+}
+
+/**
+ * @brief Rend au système les pages d'une plage, qui reste projetée
+ * 
+ * MADV_FREE laisse le noyau reprendre les pages à sa convenance ; un noyau
+ * qui ne le connaît pas reçoit MADV_DONTNEED.
+ * 
+ * @param ptr Début de la plage (aligné sur une page)
+ * @param size Taille de la plage
+ * @param advice VALLOC_PURGE_DONTNEED ou VALLOC_PURGE_FREE
+ * @return size_t Octets rendus, 0 en cas d'échec
+ */
+static size_t purge_range(void* ptr, size_t size, int advice) {
+    if (advice == VALLOC_PURGE_FREE && madvise(ptr, size, MADV_FREE) == 0) return size;
+    return madvise(ptr, size, MADV_DONTNEED) == 0 ? size : 0;
+}
 
 /**
- * @brief Obtient l'ID du thread courant
+ * @brief Purge la mémoire inutilisée d'une arène
  * 
- * Initialise et retourne un identifiant unique de thread de manière paresseuse.
- * Thread-safe grâce à la protection par mutex.
+ * Un bloc ou une span rendu au passage p n'est purgé qu'à partir du
+ * passage p + 2 : il est resté inutilisé pendant au moins un intervalle.
+ * Les chunks en grandes pages réservées sont ignorés, leurs pages ne
+ * pouvant être rendues que par 2 Mo.
+ * Doit être appelée avec le mutex de l'arène verrouillé.
  * 
- * @return int Identifiant unique du thread
+ * @param arena Arène à purger
+ * @param pass Numéro du passage en cours
+ * @param advice VALLOC_PURGE_DONTNEED ou VALLOC_PURGE_FREE
+ * @return size_t Octets rendus au système
  */
-int get_thread_id() {
-    if (thread_id == -1) {
-        pthread_mutex_lock(&thread_id_mutex);
-        thread_id = next_thread_id++;
-        pthread_mutex_unlock(&thread_id_mutex);
+static size_t arena_scavenge(Arena* arena, uint32_t pass, int advice) {
+    size_t purged = 0;
+
+    for (size_t bin = recycle_bin_next(arena, 0); bin < NUM_RECYCLE_BINS;
+         bin = recycle_bin_next(arena, bin + 1)) {
+        for (MemoryBlock* block = arena->recycled_bins[bin]; block; block = block->next) {
+            if (block->purged || pass - block->idle_pass < 2) continue;
+            purged += purge_range(block->adress, block->size, advice);
+            block->purged = true;
+        }
+    }
+
+    for (SlabChunk* chunk = arena->slab_chunks; chunk; chunk = chunk->next) {
+        if (chunk->hugetlb) continue;
+        uint64_t spans = chunk->free_spans & ~chunk->purged_spans;
+        while (spans) {
+            size_t idx = (size_t)__builtin_ctzll(spans);
+            spans &= spans - 1;
+            if (pass - chunk->spans[idx].idle_pass < 2) continue;
+            purged += purge_range((char*)chunk + idx * SLAB_SPAN_SIZE, SLAB_SPAN_SIZE, advice);
+            chunk->purged_spans |= 1ULL << idx;
+        }
     }
-    return thread_id;
+    return purged;
 }
 
 /**
- * @brief Récupère le cache thread-local pour le thread courant
+ * @brief Effectue un passage de purge
  * 
  * @param allocator Pointeur vers la structure de l'allocateur
- * @return ThreadCache* Pointeur vers le cache du thread, NULL si l'ID est invalide
+ * @return size_t Nombre d'octets rendus au système par ce passage
  */
-ThreadCache* get_thread_cache(MemoryAllocator* allocator) {
-    int id = get_thread_id();
-    if (id >= allocator->num_threads) return NULL;
-    return &allocator->thread_caches[id];
+size_t valloc_scavenge(MemoryAllocator* allocator) {
+    if (allocator == NULL || !allocator->initialized) {
+        return 0;
+    }
+
+    Scavenger* scavenger = &allocator->scavenger;
+    uint32_t pass = __atomic_add_fetch(&scavenger->pass, 1, __ATOMIC_RELAXED);
+    int advice = __atomic_load_n(&scavenger->advice, __ATOMIC_RELAXED);
+
+    // Une arène à la fois : les allocations des autres nœuds ne sont pas bloquées
+    size_t purged = 0;
+    for (int i = 0; i < VALLOC_MAX_NODES; i++) {
+        Arena* arena = &allocator->arenas[i];
+        arena_lock(allocator, arena);
+        purged += arena_scavenge(arena, pass, advice);
+        pthread_mutex_unlock(&arena->mutex);
+    }
+
+    __atomic_add_fetch(&scavenger->purged_bytes, purged, __ATOMIC_RELAXED);
+    return purged;
 }
 
 /**
- * @brief Tente d'allouer de la mémoire depuis le cache thread-local
+ * @brief Boucle du thread de purge
  * 
- * Recherche dans le cache du thread un bloc de la taille demandée.
- * Thread-safe grâce au mutex du cache.
+ * Un passage toutes les interval_ms millisecondes, jusqu'à la demande d'arrêt.
  * 
- * @param cache Cache du thread pour l'allocation
- * @param size Taille du bloc de mémoire nécessaire
- * @return void* Pointeur vers le bloc en cache, NULL si aucun bloc approprié trouvé
+ * @param arg Allocateur à purger
+ * @return void* Toujours NULL
  */
-void* cache_allocate(ThreadCache* cache, size_t size) {
-    if (!cache) return NULL;
+static void* scavenger_main(void* arg) {
+    MemoryAllocator* allocator = (MemoryAllocator*)arg;
+    Scavenger* scavenger = &allocator->scavenger;
 
-    pthread_mutex_lock(&cache->mutex);
-    for (int i = 0; i < cache->count; i++) {
-        if (cache->blocks[i].size == size) {
-            void* ptr = cache->blocks[i].ptr;
-            cache->blocks[i] = cache->blocks[--cache->count];
-            pthread_mutex_unlock(&cache->mutex);
-            return ptr;
+    pthread_mutex_lock(&scavenger->mutex);
+    while (!scavenger->stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += scavenger->interval_ms / 1000;
+        deadline.tv_nsec += (long)(scavenger->interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        int err = 0;
+        while (!scavenger->stop && err != ETIMEDOUT) {
+            err = pthread_cond_timedwait(&scavenger->wakeup, &scavenger->mutex, &deadline);
         }
+        if (scavenger->stop) break;
+
+        pthread_mutex_unlock(&scavenger->mutex);
+        valloc_scavenge(allocator);
+        pthread_mutex_lock(&scavenger->mutex);
     }
-    pthread_mutex_unlock(&cache->mutex);
+    pthread_mutex_unlock(&scavenger->mutex);
     return NULL;
 }
 
 /**
- * @brief Tente de mettre en cache un bloc de mémoire libéré
+ * @brief Lance le thread de purge en arrière-plan
  * 
- * Si le cache est plein, la mémoire est retournée au système.
- * Thread-safe grâce au mutex du cache.
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param interval_ms Intervalle entre deux passages, en millisecondes
+ * @param advice VALLOC_PURGE_DONTNEED ou VALLOC_PURGE_FREE
+ * @return int 0 en cas de succès, -1 en cas d'échec ou si le thread est déjà lancé
+ */
+int valloc_scavenger_start(MemoryAllocator* allocator, unsigned int interval_ms, int advice) {
+    if (allocator == NULL || !allocator->initialized || interval_ms == 0 ||
+        (advice != VALLOC_PURGE_DONTNEED && advice != VALLOC_PURGE_FREE)) {
+        return -1;
+    }
+
+    Scavenger* scavenger = &allocator->scavenger;
+    pthread_mutex_lock(&scavenger->mutex);
+    if (scavenger->running) {
+        pthread_mutex_unlock(&scavenger->mutex);
+        return -1;
+    }
+
+    scavenger->interval_ms = interval_ms;
+    __atomic_store_n(&scavenger->advice, advice, __ATOMIC_RELAXED);
+    scavenger->stop = false;
+    if (pthread_create(&scavenger->thread, NULL, scavenger_main, allocator) != 0) {
+        pthread_mutex_unlock(&scavenger->mutex);
+        return -1;
+    }
+    scavenger->running = true;
+    pthread_mutex_unlock(&scavenger->mutex);
+    return 0;
+}
+
+/**
+ * @brief Arrête le thread de purge et attend sa terminaison
  * 
- * @param cache Cache du thread pour le stockage
- * @param ptr Pointeur vers le bloc de mémoire
- * @param size Taille du bloc de mémoire
+ * @param allocator Pointeur vers la structure de l'allocateur
  */
-void cache_free(ThreadCache* cache, void* ptr, size_t size) {
-    if (!cache || !ptr) return;
+void valloc_scavenger_stop(MemoryAllocator* allocator) {
+    if (allocator == NULL || !allocator->initialized) {
+        return;
+    }
 
-    pthread_mutex_lock(&cache->mutex);
-    if (cache->count < MAX_CACHE_BLOCKS) {
-        cache->blocks[cache->count].ptr = ptr;
-        cache->blocks[cache->count].size = size;
-        cache->count++;
-        pthread_mutex_unlock(&cache->mutex);
+    Scavenger* scavenger = &allocator->scavenger;
+    pthread_mutex_lock(&scavenger->mutex);
+    if (!scavenger->running) {
+        pthread_mutex_unlock(&scavenger->mutex);
         return;
     }
-    pthread_mutex_unlock(&cache->mutex);
-    munmap(ptr, size);
+    scavenger->stop = true;
+    pthread_cond_signal(&scavenger->wakeup);
+    pthread_mutex_unlock(&scavenger->mutex);
+
+    pthread_join(scavenger->thread, NULL);
+
+    pthread_mutex_lock(&scavenger->mutex);
+    scavenger->running = false;
+    pthread_mutex_unlock(&scavenger->mutex);
 }
 
 /**
- * @brief Initialise l'allocateur de mémoire
+ * @brief Ajoute les compteurs d'un thread aux statistiques
  * 
- * Alloue le pool global de mémoire et initialise tous les blocs.
- * Initialise le mutex global et les caches des threads.
+ * @param stats Statistiques agrégées
+ * @param thread Compteurs d'un cache, ou compteurs partagés
+ */
+static void stats_accumulate(VallocStats* stats, ThreadStats* thread) {
+    for (size_t c = 0; c < NUM_STATS_CLASSES; c++) {
+        uint64_t allocs = __atomic_load_n(&thread->allocs[c], __ATOMIC_RELAXED);
+        stats->class_allocs[c] += allocs;
+        stats->allocs += allocs;
+    }
+    stats->frees += __atomic_load_n(&thread->frees, __ATOMIC_RELAXED);
+    stats->cache_hits += __atomic_load_n(&thread->cache_hits, __ATOMIC_RELAXED);
+    stats->cache_misses += __atomic_load_n(&thread->cache_misses, __ATOMIC_RELAXED);
+    stats->remote_frees += __atomic_load_n(&thread->remote_frees, __ATOMIC_RELAXED);
+    stats->cache_refills += __atomic_load_n(&thread->cache_refills, __ATOMIC_RELAXED);
+    stats->cache_flushes += __atomic_load_n(&thread->cache_flushes, __ATOMIC_RELAXED);
+    stats->bytes_requested += __atomic_load_n(&thread->bytes_requested, __ATOMIC_RELAXED);
+    stats->bytes_allocated += __atomic_load_n(&thread->bytes_allocated, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Relève les statistiques de l'allocateur
  * 
  * @param allocator Pointeur vers la structure de l'allocateur
- * @param initial_blocks Nombre initial de blocs dans le pool
- * @param num_threads Nombre de threads à supporter
+ * @param stats Statistiques remplies
  * @return int 0 en cas de succès, -1 en cas d'échec
  */
-int valloc_init(MemoryAllocator* allocator, size_t initial_blocks, int num_threads) {
-    if (allocator == NULL || initial_blocks == 0 || num_threads <= 0 || num_threads > MAX_THREADS) {
+int valloc_stats(MemoryAllocator* allocator, VallocStats* stats) {
+    if (allocator == NULL || !allocator->initialized || stats == NULL) {
         return -1;
     }
 
-    // Allocation du pool global de mémoire
-    allocator->blocks = (MemoryBlock*)malloc(initial_blocks * sizeof(MemoryBlock));
-    if (allocator->blocks == NULL) {
-        return -1;
+    memset(stats, 0, sizeof(*stats));
+    stats_accumulate(stats, &allocator->shared_stats);
+    int num_threads = __atomic_load_n(&allocator->num_threads, __ATOMIC_RELAXED);
+    for (int i = 0; i < num_threads; i++) {
+        ThreadCache* cache = thread_cache_at(allocator, i);
+        if (cache) stats_accumulate(stats, &cache->stats);
     }
-
-    // Initialisation de tous les blocs dans le pool
-    for (size_t i = 0; i < initial_blocks; i++) {
-        allocator->blocks[i].adress = NULL;
-        allocator->blocks[i].size = 0;
-        allocator->blocks[i].status = true;
-        allocator->blocks[i].recycled = false;
+    for (int i = 0; i < allocator->num_cpus; i++) {
+        stats_accumulate(stats, &allocator->cpu_caches[i].stats);
     }
 
-    // Initialisation du mutex global
-    if (pthread_mutex_init(&allocator->mutex, NULL) != 0) {
-        free(allocator->blocks);
-        return -1;
+    PoolStats* pool = &allocator->pool_stats;
+    stats->mmap_calls = __atomic_load_n(&pool->mmap_calls, __ATOMIC_RELAXED);
+    stats->munmap_calls = __atomic_load_n(&pool->munmap_calls, __ATOMIC_RELAXED);
+    stats->mremap_calls = __atomic_load_n(&pool->mremap_calls, __ATOMIC_RELAXED);
+    stats->bytes_mapped = __atomic_load_n(&pool->bytes_mapped, __ATOMIC_RELAXED);
+    stats->bytes_mapped_peak = __atomic_load_n(&pool->bytes_mapped_peak, __ATOMIC_RELAXED);
+    stats->class_contention = __atomic_load_n(&pool->class_contention, __ATOMIC_RELAXED);
+    stats->arena_contention = __atomic_load_n(&pool->arena_contention, __ATOMIC_RELAXED);
+    stats->global_contention = __atomic_load_n(&pool->global_contention, __ATOMIC_RELAXED);
+    stats->large_reuses = __atomic_load_n(&pool->large_reuses, __ATOMIC_RELAXED);
+    stats->sized_mismatches = __atomic_load_n(&pool->sized_mismatches, __ATOMIC_RELAXED);
+    for (int i = 0; i < VALLOC_MAX_NODES; i++) {
+        stats->bytes_recycled += __atomic_load_n(&allocator->arenas[i].recycled_bytes, __ATOMIC_RELAXED);
     }
+    stats->bytes_purged = __atomic_load_n(&allocator->scavenger.purged_bytes, __ATOMIC_RELAXED);
+    stats->used_blocks = __atomic_load_n(&allocator->used_blocks, __ATOMIC_RELAXED);
+    stats->recycled_blocks = __atomic_load_n(&allocator->recycled_blocks, __ATOMIC_RELAXED);
+    stats->num_threads = num_threads;
+    return 0;
+}
 
-    // Initialisation de l'état de l'allocateur
-    allocator->total_blocks = initial_blocks;
-    allocator->used_blocks = 0;
-    allocator->recycled_blocks = 0;
-    allocator->num_threads = num_threads;
-    allocator->initialized = true;
+/**
+ * @brief Affiche les statistiques de l'allocateur
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param stream Flux de sortie (stdout si NULL)
+ */
+void valloc_stats_print(MemoryAllocator* allocator, FILE* stream) {
+    VallocStats stats;
+    if (valloc_stats(allocator, &stats) != 0) return;
+    if (stream == NULL) stream = stdout;
 
-    // Initialisation des caches des threads
-    for (int i = 0; i < num_threads; i++) {
-        if (pthread_mutex_init(&allocator->thread_caches[i].mutex, NULL) != 0) {
-            // Nettoyage en cas d'échec
-            for (int j = 0; j < i; j++) {
-                pthread_mutex_destroy(&allocator->thread_caches[j].mutex);
-            }
-            pthread_mutex_destroy(&allocator->mutex);
-            free(allocator->blocks);
-            return -1;
+    uint64_t lookups = stats.cache_hits + stats.cache_misses;
+    fprintf(stream, "=== Statistiques valloc ===\n");
+    fprintf(stream, "Allocations        : %" PRIu64 " (%" PRIu64 " octets demandés, %" PRIu64 " servis)\n",
+            stats.allocs, stats.bytes_requested, stats.bytes_allocated);
+    fprintf(stream, "Libérations        : %" PRIu64 " (dont %" PRIu64 " rendues à un autre thread)\n",
+            stats.frees, stats.remote_frees);
+    fprintf(stream, "Caches des threads : %" PRIu64 " succès, %" PRIu64 " échecs (%.1f %% de succès), %d caches\n",
+            stats.cache_hits, stats.cache_misses, lookups ? 100.0 * stats.cache_hits / lookups : 0.0,
+            stats.num_threads);
+    fprintf(stream, "Transferts par lots : %" PRIu64 " remplissages, %" PRIu64 " vidages vers les listes centrales\n",
+            stats.cache_refills, stats.cache_flushes);
+    fprintf(stream, "Mémoire projetée   : %zu octets (pic %zu), %zu octets purgés\n",
+            stats.bytes_mapped, stats.bytes_mapped_peak, stats.bytes_purged);
+    fprintf(stream, "Appels système     : %" PRIu64 " mmap, %" PRIu64 " munmap, %" PRIu64 " mremap\n",
+            stats.mmap_calls, stats.munmap_calls, stats.mremap_calls);
+    fprintf(stream, "Contention         : %" PRIu64 " attentes de classe, %" PRIu64 " d'arène, %" PRIu64
+            " du mutex global\n", stats.class_contention, stats.arena_contention, stats.global_contention);
+    fprintf(stream, "Blocs de la table  : %zu utilisés, %zu recyclés (%zu octets)\n",
+            stats.used_blocks, stats.recycled_blocks, stats.bytes_recycled);
+    fprintf(stream, "Grands blocs       : %" PRIu64 " servis par une projection recyclée\n", stats.large_reuses);
+    if (allocator->flags & VALLOC_DEBUG_SIZED) {
+        fprintf(stream, "Libérations avec taille : %" PRIu64 " tailles erronées\n", stats.sized_mismatches);
+    }
+
+    fprintf(stream, "Allocations par classe de taille :\n");
+    for (size_t c = 0; c < NUM_STATS_CLASSES; c++) {
+        if (stats.class_allocs[c] == 0) continue;
+        if (c < NUM_CACHE_CLASSES) {
+            fprintf(stream, "  %8zu - %-8zu : %" PRIu64 "\n", cache_class_size(c), cache_class_size(c + 1) - 1,
+                    stats.class_allocs[c]);
+        } else {
+            fprintf(stream, "  %8zu et plus  : %" PRIu64 "\n", cache_class_size(c), stats.class_allocs[c]);
         }
-        allocator->thread_caches[i].count = 0;
     }
 
-    return 0;
+    fprintf(stream, "Activité par cache thread-local :\n");
+    for (int i = 0; i < stats.num_threads; i++) {
+        ThreadCache* cache = thread_cache_at(allocator, i);
+        if (cache == NULL) continue;
+        VallocStats thread;
+        memset(&thread, 0, sizeof(thread));
+        stats_accumulate(&thread, &cache->stats);
+        fprintf(stream, "  cache %4d : %" PRIu64 " allocations, %" PRIu64 " succès, %" PRIu64 " échecs, %"
+                PRIu64 " libérations\n", i, thread.allocs, thread.cache_hits, thread.cache_misses, thread.frees);
+    }
 }
 
 /**
- * @brief Alloue un bloc de mémoire
+ * @brief Arrête le thread d'écriture des profils et rend le signal à son action par défaut
  * 
- * Tente d'abord d'allouer depuis le cache thread-local.
- * Si l'allocation du cache échoue, recherche un bloc recyclé dans le pool global.
- * Si aucun bloc recyclé n'est disponible, alloue de la nouvelle mémoire.
+ * @param allocator Pointeur vers la structure de l'allocateur
+ */
+static void profile_dumper_stop(MemoryAllocator* allocator) {
+    Profiler* profiler = &allocator->profiler;
+    if (!profiler->dumper_running) return;
+
+    signal(profiler->dump_signal, SIG_DFL);
+    MemoryAllocator* expected = allocator;
+    __atomic_compare_exchange_n(&profile_signal_allocator, &expected, NULL, false,
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+
+    __atomic_store_n(&profiler->dumper_stop, true, __ATOMIC_RELEASE);
+    sem_post(&profiler->dump_request);
+    pthread_join(profiler->dumper, NULL);
+    profiler->dumper_running = false;
+}
+
+/**
+ * @brief Active le profileur de tas
  * 
  * @param allocator Pointeur vers la structure de l'allocateur
- * @param size Taille du bloc de mémoire nécessaire
- * @return void* Pointeur vers le bloc de mémoire alloué, NULL en cas d'échec
+ * @param period Nombre moyen d'octets alloués entre deux échantillons
+ *        (0 : VALLOC_PROFILE_DEFAULT_PERIOD)
+ * @return int 0 en cas de succès, -1 en cas d'échec
  */
-void* valloc_block(MemoryAllocator* allocator, size_t size) {
-    if (allocator == NULL || !allocator->initialized || size == 0) {
-        return NULL;
+int valloc_profile_start(MemoryAllocator* allocator, size_t period) {
+    if (allocator == NULL || !allocator->initialized) {
+        return -1;
     }
 
-    // Chemin rapide : essai du cache thread-local d'abord
-    ThreadCache* cache = get_thread_cache(allocator);
-    if (cache) {
-        void* ptr = cache_allocate(cache, size);
-        if (ptr) return ptr;
+    // Premier appel à backtrace hors de tout verrou : il peut charger le
+    // dérouleur de pile (dlopen, qui alloue)
+    void* frame;
+    backtrace(&frame, 1);
+
+    __atomic_store_n(&allocator->profiler.period, period ? period : VALLOC_PROFILE_DEFAULT_PERIOD,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&allocator->profiling, true, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Arrête l'échantillonnage
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ */
+void valloc_profile_stop(MemoryAllocator* allocator) {
+    if (allocator == NULL || !allocator->initialized) {
+        return;
     }
+    __atomic_store_n(&allocator->profiling, false, __ATOMIC_RELEASE);
+}
 
-    // Chemin lent : accès au pool global
-    pthread_mutex_lock(&allocator->mutex);
+/**
+ * @brief Nombre d'octets représentés par un échantillon
+ * 
+ * Un objet de size octets est échantillonné avec la probabilité
+ * 1 - exp(-size / period) : il représente size / probabilité octets.
+ * 
+ * @param size Taille de l'objet échantillonné
+ * @param period Période d'échantillonnage
+ * @return double Octets estimés
+ */
+static double profile_weight(size_t size, size_t period) {
+    double probability = 1.0 - profile_exp_neg((double)size / (double)period);
+    return probability > 0.0 ? (double)size / probability : (double)period;
+}
 
-    // Recherche d'abord un bloc recyclé
-    for (size_t i = 0; i < allocator->total_blocks; i++) {
-        if (allocator->blocks[i].status && allocator->blocks[i].recycled && 
-            allocator->blocks[i].size >= size) {
-            allocator->blocks[i].status = false;
-            allocator->blocks[i].recycled = false;
-            allocator->used_blocks++;
-            allocator->recycled_blocks--;
-            void* ptr = allocator->blocks[i].adress;
-            pthread_mutex_unlock(&allocator->mutex);
-            return ptr;
+/**
+ * @brief Écrit une adresse de la pile, symbolisée si possible
+ * 
+ * @param stream Flux de sortie
+ * @param address Adresse de retour
+ */
+static void profile_write_frame(FILE* stream, void* address) {
+    Dl_info info;
+    if (dladdr(address, &info) && info.dli_sname) {
+        fprintf(stream, "%s+0x%lx", info.dli_sname, (unsigned long)((char*)address - (char*)info.dli_saddr));
+    } else if (info.dli_fname) {
+        const char* name = strrchr(info.dli_fname, '/');
+        fprintf(stream, "%s+0x%lx", name ? name + 1 : info.dli_fname,
+                (unsigned long)((char*)address - (char*)info.dli_fbase));
+    } else {
+        fprintf(stream, "%p", address);
+    }
+}
+
+/**
+ * @brief Écrit un profil plat : piles regroupées, triées par octets estimés
+ * 
+ * @param stream Flux de sortie
+ * @param samples Copie des échantillons vivants
+ * @param count Nombre d'échantillons
+ * @param period Période d'échantillonnage
+ */
+static void profile_write_text(FILE* stream, ProfileSample* samples, size_t count, size_t period) {
+    // Un groupe par pile distincte : le premier échantillon, le nombre et les octets estimés
+    typedef struct {
+        ProfileSample* sample;
+        size_t count;
+        double bytes;
+    } ProfileGroup;
+
+    ProfileGroup* groups = count ? (ProfileGroup*)meta_alloc(count * sizeof(ProfileGroup)) : NULL;
+    if (count && groups == NULL) return;
+
+    size_t num_groups = 0;
+    double total = 0;
+    for (size_t i = 0; i < count; i++) {
+        ProfileSample* sample = &samples[i];
+        double bytes = profile_weight(sample->size, period);
+        total += bytes;
+
+        size_t g = 0;
+        while (g < num_groups && (groups[g].sample->depth != sample->depth ||
+                                  memcmp(groups[g].sample->stack, sample->stack,
+                                         (size_t)sample->depth * sizeof(void*)) != 0)) {
+            g++;
+        }
+        if (g == num_groups) {
+            groups[num_groups].sample = sample;
+            groups[num_groups].count = 0;
+            groups[num_groups].bytes = 0;
+            num_groups++;
         }
+        groups[g].count++;
+        groups[g].bytes += bytes;
     }
 
-    // Allocation de nouvelle mémoire si aucun bloc recyclé disponible
-    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (ptr == MAP_FAILED) {
-        pthread_mutex_unlock(&allocator->mutex);
-        return NULL;
+    // Tri par insertion, du plus gros consommateur au plus petit
+    for (size_t i = 1; i < num_groups; i++) {
+        ProfileGroup group = groups[i];
+        size_t j = i;
+        while (j > 0 && groups[j - 1].bytes < group.bytes) {
+            groups[j] = groups[j - 1];
+            j--;
+        }
+        groups[j] = group;
     }
 
-    // Recherche d'un emplacement libre dans le tableau de blocs
-    for (size_t i = 0; i < allocator->total_blocks; i++) {
-        if (allocator->blocks[i].status && !allocator->blocks[i].recycled) {
-            allocator->blocks[i].adress = ptr;
-            allocator->blocks[i].size = size;
-            allocator->blocks[i].status = false;
-            allocator->blocks[i].recycled = false;
-            allocator->used_blocks++;
-            pthread_mutex_unlock(&allocator->mutex);
-            return ptr;
+    fprintf(stream, "valloc heap profile : %zu échantillons vivants, %.0f octets estimés (période %zu)\n",
+            count, total, period);
+    fprintf(stream, "%14s %7s %8s  %s\n", "octets", "%", "échant.", "pile d'appels");
+    for (size_t g = 0; g < num_groups; g++) {
+        fprintf(stream, "%14.0f %6.1f%% %8zu  ", groups[g].bytes, total > 0 ? 100.0 * groups[g].bytes / total : 0.0,
+                groups[g].count);
+        for (int f = 0; f < groups[g].sample->depth; f++) {
+            if (f) fprintf(stream, " < ");
+            profile_write_frame(stream, groups[g].sample->stack[f]);
         }
+        fprintf(stream, "\n");
     }
 
-    // Aucun emplacement libre disponible
-    munmap(ptr, size);
-    pthread_mutex_unlock(&allocator->mutex);
-    return NULL;
+    meta_free(groups, count * sizeof(ProfileGroup));
 }
 
 /**
- * @brief Libère un bloc de mémoire
+ * @brief Écrit un profil de tas au format historique de pprof (heap_v2)
  * 
- * Tente d'abord de mettre le bloc en cache.
- * Si la mise en cache échoue, retourne le bloc au système.
+ * Une ligne par échantillon, avec sa taille réelle : pprof corrige lui-même
+ * l'échantillonnage à partir de la période. Les projections du processus
+ * suivent, pour la symbolisation.
  * 
- * @param allocator Pointeur vers la structure de l'allocateur
- * @param ptr Pointeur vers le bloc de mémoire à libérer
+ * @param stream Flux de sortie
+ * @param samples Copie des échantillons vivants
+ * @param count Nombre d'échantillons
+ * @param period Période d'échantillonnage
  */
-void free_valloc(MemoryAllocator* allocator, void* ptr) {
-    if (allocator == NULL || !allocator->initialized || ptr == NULL) {
-        return;
-    }
-
-    pthread_mutex_lock(&allocator->mutex);
-
-    // Recherche du bloc dans le pool global
-    for (size_t i = 0; i < allocator->total_blocks; i++) {
-        if (allocator->blocks[i].adress == ptr) {
-            size_t size = allocator->blocks[i].size;
-            
-            // Tente d'abord de mettre en cache le bloc
-            ThreadCache* cache = get_thread_cache(allocator);
-            if (cache) {
-                cache_free(cache, ptr, size);
-            } else {
-                munmap(ptr, size);
-            }
+static void profile_write_pprof(FILE* stream, ProfileSample* samples, size_t count, size_t period) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) total += samples[i].size;
 
-            // Mise à jour du statut du bloc
-            allocator->blocks[i].status = true;
-            allocator->blocks[i].adress = NULL;
-            allocator->blocks[i].recycled = false;
-            allocator->used_blocks--;
-            pthread_mutex_unlock(&allocator->mutex);
-            return;
+    fprintf(stream, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n", count, total, count, total, period);
+    for (size_t i = 0; i < count; i++) {
+        fprintf(stream, "1: %zu [1: %zu] @", samples[i].size, samples[i].size);
+        for (int f = 0; f < samples[i].depth; f++) {
+            fprintf(stream, " 0x%lx", (unsigned long)(uintptr_t)samples[i].stack[f]);
         }
+        fprintf(stream, "\n");
     }
 
-    pthread_mutex_unlock(&allocator->mutex);
+    fprintf(stream, "\nMAPPED_LIBRARIES:\n");
+    int fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        char buf[4096];
+        ssize_t len;
+        while ((len = read(fd, buf, sizeof(buf))) > 0) fwrite(buf, 1, (size_t)len, stream);
+        close(fd);
+    }
 }
 
 /**
- * @brief Recycle un bloc de mémoire
+ * @brief Écrit le profil des échantillons vivants
  * 
- * Marque le bloc comme recyclé et disponible pour réutilisation.
+ * Les échantillons sont copiés sous le verrou, puis écrits sans lui :
+ * l'écriture peut allouer et libérer (tampons de stdio).
  * 
  * @param allocator Pointeur vers la structure de l'allocateur
- * @param ptr Pointeur vers le bloc de mémoire à recycler
+ * @param stream Flux de sortie
+ * @param format VALLOC_PROFILE_TEXT ou VALLOC_PROFILE_PPROF
+ * @return int Nombre d'échantillons écrits, -1 en cas d'échec
  */
-void revalloc(MemoryAllocator* allocator, void* ptr) {
-    if (allocator == NULL || !allocator->initialized || ptr == NULL) {
-        return;
+int valloc_profile_dump(MemoryAllocator* allocator, FILE* stream, int format) {
+    if (allocator == NULL || !allocator->initialized || stream == NULL ||
+        (format != VALLOC_PROFILE_TEXT && format != VALLOC_PROFILE_PPROF)) {
+        return -1;
     }
 
-    pthread_mutex_lock(&allocator->mutex);
-
+    Profiler* profiler = &allocator->profiler;
+    pthread_mutex_lock(&profiler->mutex);
+    size_t capacity = profiler->count;
+    ProfileSample* samples = capacity ? (ProfileSample*)meta_alloc(capacity * sizeof(ProfileSample)) : NULL;
+    if (capacity && samples == NULL) {
+        pthread_mutex_unlock(&profiler->mutex);
+        return -1;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < profiler->capacity; i++) {
+        void* ptr = profiler->samples[i].ptr;
+        if (ptr != NULL && ptr != PROFILE_TOMBSTONE) samples[count++] = profiler->samples[i];
+    }
+    size_t period = __atomic_load_n(&profiler->period, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&profiler->mutex);
 
-    for (size_t i = 0; i < allocator->total_blocks; i++) {
-        if (allocator->blocks[i].adress == ptr) {
-            allocator->blocks[i].status = true;
-            allocator->blocks[i].recycled = true;
-            allocator->used_blocks--;
-            allocator->recycled_blocks++;
-            pthread_mutex_unlock(&allocator->mutex);
-            return;
-        }
+    // Les allocations de stdio ne sont pas échantillonnées
+    bool nested = tls_in_profile;
+    tls_in_profile = true;
+    if (format == VALLOC_PROFILE_PPROF) {
+        profile_write_pprof(stream, samples, count, period);
+    } else {
+        profile_write_text(stream, samples, count, period);
     }
+    fflush(stream);
+    tls_in_profile = nested;
 
-    pthread_mutex_unlock(&allocator->mutex);
+    meta_free(samples, capacity * sizeof(ProfileSample));
+    return (int)count;
 }
 
 /**
- * @brief Nettoie l'allocateur
+ * @brief Gestionnaire du signal de valloc_profile_signal
+ * 
+ * sem_post est utilisable depuis un gestionnaire de signal, contrairement à stdio.
+ * 
+ * @param signo Signal reçu
+ */
+static void profile_signal_handler(int signo) {
+    (void)signo;
+    MemoryAllocator* allocator = __atomic_load_n(&profile_signal_allocator, __ATOMIC_ACQUIRE);
+    if (allocator) sem_post(&allocator->profiler.dump_request);
+}
+
+/**
+ * @brief Boucle du thread écrivant les profils demandés par signal
  * 
- * Libère tous les blocs recyclés et les caches des threads.
+ * @param arg Allocateur profilé
+ * @return void* Toujours NULL
+ */
+static void* profile_dumper_main(void* arg) {
+    MemoryAllocator* allocator = (MemoryAllocator*)arg;
+    Profiler* profiler = &allocator->profiler;
+    tls_in_profile = true;
+
+    for (;;) {
+        while (sem_wait(&profiler->dump_request) != 0 && errno == EINTR) {
+        }
+        if (__atomic_load_n(&profiler->dumper_stop, __ATOMIC_ACQUIRE)) break;
+
+        char path[sizeof(profiler->dump_prefix) + 32];
+        snprintf(path, sizeof(path), "%s.%04u.heap", profiler->dump_prefix, profiler->dump_seq++);
+        FILE* file = fopen(path, "w");
+        if (file == NULL) continue;
+        valloc_profile_dump(allocator, file, VALLOC_PROFILE_PPROF);
+        fclose(file);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Écrit un profil pprof à chaque réception d'un signal
  * 
  * @param allocator Pointeur vers la structure de l'allocateur
+ * @param signo Signal déclencheur
+ * @param prefix Préfixe des fichiers écrits
+ * @return int 0 en cas de succès, -1 en cas d'échec
  */
-void valloc_cleanup(MemoryAllocator* allocator) {
-    if (allocator == NULL || !allocator->initialized) {
-        return;
+int valloc_profile_signal(MemoryAllocator* allocator, int signo, const char* prefix) {
+    if (allocator == NULL || !allocator->initialized || signo <= 0 || prefix == NULL) {
+        return -1;
     }
 
-    pthread_mutex_lock(&allocator->mutex);
+    Profiler* profiler = &allocator->profiler;
+    if (profiler->dumper_running || strlen(prefix) >= sizeof(profiler->dump_prefix)) return -1;
 
+    MemoryAllocator* expected = NULL;
+    if (!__atomic_compare_exchange_n(&profile_signal_allocator, &expected, allocator, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return -1;
+    }
 
-    for (size_t i = 0; i < allocator->total_blocks; i++) {
-        if (allocator->blocks[i].recycled) {
-            munmap(allocator->blocks[i].adress, allocator->blocks[i].size);
-            allocator->blocks[i].adress = NULL;
-            allocator->blocks[i].size = 0;
-            allocator->blocks[i].status = true;
-            allocator->blocks[i].recycled = false;
-            allocator->recycled_blocks--;
-        }
+    strcpy(profiler->dump_prefix, prefix);
+    profiler->dump_signal = signo;
+    profiler->dumper_stop = false;
+    if (pthread_create(&profiler->dumper, NULL, profile_dumper_main, allocator) != 0) {
+        __atomic_store_n(&profile_signal_allocator, NULL, __ATOMIC_RELEASE);
+        return -1;
     }
+    profiler->dumper_running = true;
 
-    pthread_mutex_unlock(&allocator->mutex);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = profile_signal_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(signo, &action, NULL) != 0) {
+        profile_dumper_stop(allocator);
+        return -1;
+    }
+    return 0;
 }
 
 /**
@@ -330,34 +3853,53 @@ void valloc_destroy(MemoryAllocator* allocator) {
         return;
     }
 
+    valloc_scavenger_stop(allocator);
+    valloc_profile_stop(allocator);
+    profile_dumper_stop(allocator);
     valloc_cleanup(allocator);
     
 
+    // Les blocs en cache sont toujours enregistrés dans la table :
+    // ils sont libérés avec les blocs occupés ci-dessous.
+    // Plus aucun thread ne doit utiliser l'allocateur à ce stade.
+    pthread_key_delete(allocator->cache_key);
     for (int i = 0; i < allocator->num_threads; i++) {
-        ThreadCache* cache = &allocator->thread_caches[i];
-        pthread_mutex_lock(&cache->mutex);
-        
-
-        for (int j = 0; j < cache->count; j++) {
-            munmap(cache->blocks[j].ptr, cache->blocks[j].size);
-        }
-        cache->count = 0;
-        
-        pthread_mutex_unlock(&cache->mutex);
-        pthread_mutex_destroy(&cache->mutex);
+        meta_free(thread_cache_at(allocator, i), sizeof(ThreadCache));
     }
+    for (size_t i = 0; i < CACHE_REGISTRY_CHUNKS; i++) {
+        meta_free(allocator->thread_caches[i], CACHE_REGISTRY_CHUNK_SIZE * sizeof(ThreadCache*));
+    }
+    meta_free(allocator->cpu_caches, (size_t)allocator->num_cpus * sizeof(CpuCache));
+    allocator->cpu_caches = NULL;
+    allocator->num_cpus = 0;
 
 
     pthread_mutex_lock(&allocator->mutex);
-    for (size_t i = 0; i < allocator->total_blocks; i++) {
-        if (!allocator->blocks[i].status) {
-            munmap(allocator->blocks[i].adress, allocator->blocks[i].size);
+    for (size_t i = 0; i < allocator->next_block; i++) {
+        MemoryBlock* block = block_at(allocator, i);
+        if (!block->status) {
+            munmap(block->adress, block->size);
         }
     }
     
-    free(allocator->blocks);
+    pagemap_destroy(allocator->page_map);
+    for (size_t i = 0; i < allocator->block_chunk_count; i++) {
+        size_t count = (size_t)1 << (allocator->block_chunk_shift + i);
+        meta_free(allocator->block_chunks[i], count * sizeof(MemoryBlock));
+    }
     pthread_mutex_unlock(&allocator->mutex);
     pthread_mutex_destroy(&allocator->mutex);
+    for (int i = 0; i < VALLOC_MAX_NODES; i++) {
+        pthread_mutex_destroy(&allocator->arenas[i].mutex);
+        for (size_t c = 0; c < NUM_SIZE_CLASSES; c++) {
+            pthread_mutex_destroy(&allocator->arenas[i].classes[c].mutex);
+        }
+    }
+    pthread_cond_destroy(&allocator->scavenger.wakeup);
+    pthread_mutex_destroy(&allocator->scavenger.mutex);
+    meta_free(allocator->profiler.samples, allocator->profiler.capacity * sizeof(ProfileSample));
+    sem_destroy(&allocator->profiler.dump_request);
+    pthread_mutex_destroy(&allocator->profiler.mutex);
     
     allocator->initialized = false;
 }
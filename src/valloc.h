@@ -2,39 +2,209 @@
 #define VALLOC_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <pthread.h>
+#include <semaphore.h>
 #include <stdbool.h>
 
-// Nombre maximum de blocs pouvant être mis en cache par thread
+// Nombre maximum de blocs mis en cache par thread pour chaque classe de petits objets
 #define MAX_CACHE_BLOCKS 32
-// Nombre maximum de threads supportés par l'allocateur
-#define MAX_THREADS 16
+// Nombre maximum de blocs mis en cache par thread pour chaque classe de grands blocs
+#define MAX_CACHE_LARGE_BLOCKS 4
+// Nombre maximum de blocs en attente sur la pile distante d'un cache ; au-delà,
+// les blocs rendus par les autres threads retournent aux listes centrales
+#define MAX_REMOTE_BLOCKS 1024
+// Propriétaire d'une span : aucun thread n'y a encore taillé, ou plusieurs
+#define SPAN_UNOWNED (-1)
+#define SPAN_SHARED (-2)
+// Caches thread-locaux par tranche du registre (2^6)
+#define CACHE_REGISTRY_CHUNK_SHIFT 6
+#define CACHE_REGISTRY_CHUNK_SIZE (1 << CACHE_REGISTRY_CHUNK_SHIFT)
+// Nombre de tranches du registre des caches
+#define CACHE_REGISTRY_CHUNKS 1024
+// Nombre maximum de threads vivants simultanément disposant d'un cache
+#define MAX_THREADS (CACHE_REGISTRY_CHUNKS * CACHE_REGISTRY_CHUNK_SIZE)
+
+// Taille d'une page (2^12 = 4 KiB)
+#define VALLOC_PAGE_SHIFT 12
+// Bits d'index par niveau de la table des pages (3 niveaux couvrent 48 bits d'adresse)
+#define PAGEMAP_LEVEL_BITS 12
+#define PAGEMAP_LEVEL_SIZE (1 << PAGEMAP_LEVEL_BITS)
+
+// Taille minimale de la première tranche de la table des blocs (2^6 emplacements)
+#define BLOCK_TABLE_MIN_SHIFT 6
+// Nombre maximal de tranches de la table, chacune deux fois plus grande que la précédente
+#define BLOCK_TABLE_CHUNKS 32
+
+// Subdivisions de chaque puissance de 2 pour les classes de blocs recyclés (2^2)
+#define RECYCLE_BIN_SUBDIV_BITS 2
+// Nombre de classes de blocs recyclés (de 2^4 à 2^63, 4 classes par puissance)
+#define NUM_RECYCLE_BINS 240
+#define RECYCLE_BITMAP_WORDS ((NUM_RECYCLE_BINS + 63) / 64)
+// Nombre maximum de blocs examinés dans une classe pour le best-fit
+#define RECYCLE_BIN_SEARCH_DEPTH 8
+
+// Taille d'un chunk de slabs (2 MiB, aligné sur sa taille)
+#define SLAB_CHUNK_SHIFT 21
+#define SLAB_CHUNK_SIZE ((size_t)1 << SLAB_CHUNK_SHIFT)
+// Taille d'une span (64 KiB), découpée en objets d'une même classe
+#define SLAB_SPAN_SHIFT 16
+#define SLAB_SPAN_SIZE ((size_t)1 << SLAB_SPAN_SHIFT)
+// Spans par chunk (la span 0 contient l'en-tête du chunk)
+#define SLAB_SPANS_PER_CHUNK (SLAB_CHUNK_SIZE / SLAB_SPAN_SIZE)
+// Mots du bitmap d'une span (un bit par objet de 16 octets au plus)
+#define SLAB_BITMAP_WORDS (SLAB_SPAN_SIZE / 16 / 64)
+// Plus grande taille servie par les slabs, au-delà un mmap dédié par bloc
+#define SLAB_MAX_SIZE 8192
+// Taille des grandes pages (2 MiB, celle des chunks de slabs)
+#define VALLOC_HUGE_PAGE_SIZE SLAB_CHUNK_SIZE
+
+// Options de valloc_init_flags
+// Grandes pages transparentes (madvise MADV_HUGEPAGE) pour les chunks et les grands blocs
+#define VALLOC_HUGE_PAGES 0x1u
+// Grandes pages réservées (MAP_HUGETLB) pour les chunks, repli sur VALLOC_HUGE_PAGES si indisponibles
+#define VALLOC_HUGETLB 0x2u
+// Une arène par nœud NUMA, mémoire liée à son nœud par mbind
+#define VALLOC_NUMA 0x4u
+// Caches de petits objets par processeur (rseq), repli sur les caches thread-locaux sans rseq
+#define VALLOC_PERCPU 0x8u
+// Vérification par free_valloc_sized de la taille annoncée contre les métadonnées
+#define VALLOC_DEBUG_SIZED 0x10u
+#define VALLOC_FLAGS_ALL (VALLOC_HUGE_PAGES | VALLOC_HUGETLB | VALLOC_NUMA | VALLOC_PERCPU | VALLOC_DEBUG_SIZED)
+
+// Objets conservés par processeur pour chaque classe de petits objets
+#define CPU_CACHE_DEPTH 64
+
+// Conseils madvise de la purge : pages rendues immédiatement (RSS mis à jour
+// tout de suite) ou paresseusement, reprises par le noyau sous pression mémoire
+#define VALLOC_PURGE_DONTNEED 0
+#define VALLOC_PURGE_FREE 1
+
+// Profondeur maximale des piles d'appels enregistrées par le profileur
+#define VALLOC_PROFILE_MAX_DEPTH 32
+// Période d'échantillonnage par défaut du profileur (octets alloués entre deux échantillons)
+#define VALLOC_PROFILE_DEFAULT_PERIOD ((size_t)512 * 1024)
+// Formats de valloc_profile_dump : profil plat lisible, ou profil de tas pprof (heap_v2)
+#define VALLOC_PROFILE_TEXT 0
+#define VALLOC_PROFILE_PPROF 1
+
+// Nombre maximal d'arènes (nœuds NUMA)
+#define VALLOC_MAX_NODES 8
+
+// Alignement maximal de valloc_aligned (2 MiB)
+#define VALLOC_MAX_ALIGNMENT SLAB_CHUNK_SIZE
+// Nombre de classes de taille des petits objets (de 16 o à SLAB_MAX_SIZE)
+#define NUM_SIZE_CLASSES 32
+// Plus grand bloc conservé dans les caches thread-locaux (1 MiB)
+#define CACHE_MAX_SIZE ((size_t)1 << 20)
+// Octets recyclés par arène au-delà desquels un grand bloc libéré est rendu au système (256 MiB)
+#define VALLOC_LARGE_CACHE_DEFAULT ((size_t)256 << 20)
+// Classes du cache : petits objets puis 4 classes par puissance de 2 jusqu'à CACHE_MAX_SIZE
+#define NUM_CACHE_CLASSES (NUM_SIZE_CLASSES + 29)
+// Classes des statistiques : classes du cache, puis une classe pour les blocs au-delà de CACHE_MAX_SIZE
+#define NUM_STATS_CLASSES (NUM_CACHE_CLASSES + 1)
 
 /**
  * @brief Structure d'un bloc de cache thread-local
  * 
- * Représente un bloc unique dans le cache thread-local.
- * Utilisé pour stocker les blocs de mémoire récemment libérés
- * pour une réutilisation rapide.
+ * Écrite au début du bloc libéré lui-même : les listes du cache
+ * et le canal entre threads ne demandent aucune allocation.
  */
 typedef struct CacheBlock {
-    void* ptr;          // Pointeur vers le bloc de mémoire
-    size_t size;        // Taille du bloc de mémoire
+    struct CacheBlock* next;    // Bloc suivant dans la liste
+    size_t size;                // Taille du bloc de mémoire
 } CacheBlock;
 
+/**
+ * @brief Liste de blocs libres d'une classe du cache thread-local
+ */
+typedef struct CacheBin {
+    CacheBlock* head;           // Premier bloc libre
+    uint32_t count;             // Nombre de blocs dans la liste
+    uint32_t limit;             // Profondeur maximale de la liste
+} CacheBin;
+
+/**
+ * @brief Compteurs d'activité d'un thread
+ * 
+ * Tenus dans le cache du thread, qui en est le seul écrivain : le chemin
+ * rapide ne les met à jour qu'avec des écritures ordinaires, sans
+ * instruction atomique ni ligne de cache partagée.
+ */
+typedef struct ThreadStats {
+    uint64_t allocs[NUM_STATS_CLASSES];   // Allocations par classe de taille
+    uint64_t frees;                       // Libérations (free_valloc et revalloc)
+    uint64_t cache_hits;                  // Allocations servies par le cache
+    uint64_t cache_misses;                // Allocations passées par le chemin lent
+    uint64_t remote_frees;                // Blocs rendus au cache d'un autre thread
+    uint64_t cache_refills;               // Lots pris aux slabs sur un échec du cache
+    uint64_t cache_flushes;               // Lots rendus aux listes centrales par un cache plein
+    uint64_t bytes_requested;             // Octets demandés
+    uint64_t bytes_allocated;             // Octets servis (arrondis à la classe)
+} ThreadStats;
+
 /**
  * @brief Structure du cache thread-local
  * 
  * Chaque thread maintient son propre cache de blocs de mémoire
  * récemment libérés pour réduire la contention et améliorer
- * la vitesse d'allocation.
+ * la vitesse d'allocation. Une liste simplement chaînée par classe
+ * de taille donne un succès ou un échec en O(1).
+ * 
+ * bins n'est accédé que par le thread propriétaire, sans verrou
+ * ni atomique. Les autres threads passent uniquement par la pile
+ * atomique remote : un bloc libéré par un thread qui ne l'a pas
+ * alloué y est rendu à son propriétaire, qui la vide par lots
+ * à sa prochaine allocation.
+ * 
+ * Les échanges avec les listes centrales se font par lots d'une demi-liste,
+ * sous un seul verrouillage d'arène : un échec remplit la liste depuis
+ * les spans partielles, une liste pleine rend ses blocs les plus anciens
+ * aux spans et aux classes de recyclage.
+ * 
+ * Les caches sont enregistrés dynamiquement à la première allocation
+ * d'un thread ; à sa terminaison, le cache est vidé vers le pool global
+ * et son indice est réattribué au prochain thread.
  */
 typedef struct ThreadCache {
-    CacheBlock blocks[MAX_CACHE_BLOCKS];  // Tableau des blocs en cache
-    int count;                            // Nombre de blocs actuellement en cache
-    pthread_mutex_t mutex;                // Mutex pour les opérations thread-safe
+    CacheBin bins[NUM_CACHE_CLASSES];     // Listes de blocs par classe de taille
+    CacheBlock* remote;                   // Pile MPSC des blocs rendus par d'autres threads
+    uint32_t remote_count;                // Blocs empilés sur remote et pas encore repris
+    struct MemoryAllocator* allocator;    // Allocateur propriétaire du cache
+    int index;                            // Indice du cache dans le registre
+    struct ThreadCache* next_free;        // Chaînage des caches de threads terminés
+    bool dead;                            // Thread terminé : les blocs rendus vont aux listes centrales
+    ThreadStats stats;                    // Activité des threads ayant utilisé ce cache
 } ThreadCache;
 
+/**
+ * @brief Liste d'une classe de petits objets dans le cache d'un processeur
+ * 
+ * Pile en tableau : une séquence rseq la modifie par une seule écriture
+ * de count, qui valide l'opération.
+ */
+typedef struct CpuBin {
+    uint32_t count;                       // Nombre d'objets dans la pile
+    uint32_t unused;                      // Bourrage : slots au déplacement 8
+    void* slots[CPU_CACHE_DEPTH];         // Objets libres, le dernier au sommet
+} CpuBin;
+
+/**
+ * @brief Cache de petits objets d'un processeur (VALLOC_PERCPU)
+ * 
+ * Partagé par tous les threads qui s'exécutent sur le processeur : sa
+ * taille ne dépend pas du nombre de threads. Les piles ne sont modifiées
+ * que par des séquences restartables (rseq) : une préemption ou une
+ * migration au milieu d'une opération la fait recommencer, sans verrou
+ * ni instruction atomique. Les compteurs, mis à jour sans atomique, sont
+ * approximatifs : une préemption peut faire perdre un incrément.
+ */
+typedef struct CpuCache {
+    CpuBin bins[NUM_SIZE_CLASSES];        // Piles par classe de petits objets
+    ThreadStats stats;                    // Activité des threads sur ce processeur
+} __attribute__((aligned(64))) CpuCache;
+
 /**
  * @brief Structure des métadonnées d'un bloc de mémoire
  * 
@@ -45,36 +215,321 @@ typedef struct MemoryBlock {
     void* adress;       // Adresse du bloc de mémoire alloué
     size_t size;        // Taille du bloc de mémoire
     bool status;        // true = libre, false = occupé
+    bool sampled;       // true si le bloc est un échantillon vivant du profileur
     bool recycled;      // true si le bloc est dans le cache de recyclage
+    bool slab;          // true si le bloc est un chunk de slabs
+    bool purged;        // true si les pages du bloc recyclé ont été rendues au système
+    uint32_t idle_pass; // Passage de la purge lors du recyclage
+    int owner;          // Thread ayant alloué le bloc (-1 si aucun)
+    int arena;          // Arène (nœud NUMA) d'où provient la mémoire du bloc
+    struct MemoryBlock* next; // Chaînage (emplacements libres ou classe de recyclage)
+    struct MemoryBlock* prev; // Chaînage arrière dans la classe de recyclage
 } MemoryBlock;
 
+/**
+ * @brief Span de petits objets
+ * 
+ * Portion de SLAB_SPAN_SIZE octets d'un chunk, découpée en objets
+ * d'une seule classe de taille. Un bitmap indique les objets libres.
+ */
+typedef struct SlabSpan {
+    struct SlabSpan* next;      // Span suivante de la classe (spans non pleines)
+    struct SlabSpan* prev;      // Span précédente de la classe
+    char* start;                // Adresse du premier objet
+    uint32_t size_class;        // Classe de taille des objets
+    uint32_t object_size;       // Taille d'un objet
+    uint32_t capacity;          // Nombre d'objets, 0 si la span est inutilisée
+    uint32_t free_count;        // Nombre d'objets libres
+    uint32_t sampled;           // Objets de la span échantillonnés par le profileur
+    uint32_t hint;              // Premier mot du bitmap pouvant contenir un objet libre
+    int32_t owner;              // Seul thread ayant taillé dans la span, SPAN_UNOWNED ou SPAN_SHARED
+    uint32_t idle_pass;         // Passage de la purge lors du retour de la span au chunk
+    uint64_t bitmap[SLAB_BITMAP_WORDS]; // 1 = objet libre
+} SlabSpan;
+
+/**
+ * @brief En-tête d'un chunk de slabs
+ * 
+ * Placé au début de chaque chunk de SLAB_CHUNK_SIZE octets obtenu par mmap.
+ * Le chunk est enregistré comme un seul MemoryBlock dans la table et toutes
+ * ses pages pointent vers ce bloc dans la table des pages.
+ */
+typedef struct SlabChunk {
+    MemoryBlock* block;         // Entrée de la table des blocs
+    struct SlabChunk* next;     // Chunk suivant disposant de spans libres
+    struct SlabChunk* prev;     // Chunk précédent disposant de spans libres
+    uint64_t free_spans;        // Bitmap des spans inutilisées
+    uint64_t purged_spans;      // Spans inutilisées dont les pages ont été rendues
+    bool hugetlb;               // Chunk pris dans les grandes pages réservées (jamais purgé)
+    SlabSpan spans[SLAB_SPANS_PER_CHUNK];
+} SlabChunk;
+
+/**
+ * @brief Feuille de la table des pages
+ * 
+ * Associe chaque page d'une plage de 2^12 pages au bloc
+ * dont l'adresse commence sur cette page, ou au chunk de slabs
+ * qui la contient.
+ */
+typedef struct PageMapLeaf {
+    MemoryBlock* blocks[PAGEMAP_LEVEL_SIZE];
+} PageMapLeaf;
+
+/**
+ * @brief Nœud intermédiaire de la table des pages
+ */
+typedef struct PageMapNode {
+    PageMapLeaf* leaves[PAGEMAP_LEVEL_SIZE];
+} PageMapNode;
+
+/**
+ * @brief Table des pages (arbre radix à 3 niveaux)
+ * 
+ * Index adresse -> métadonnées permettant de retrouver en temps
+ * constant le MemoryBlock d'un pointeur, indépendamment du nombre
+ * de blocs dans le pool. Les nœuds sont alloués paresseusement.
+ */
+typedef struct PageMap {
+    PageMapNode* nodes[PAGEMAP_LEVEL_SIZE];
+} PageMap;
+
+/**
+ * @brief Liste centrale d'une classe de petits objets
+ * 
+ * Spans non pleines d'une classe, sous un verrou propre : les remplissages
+ * et vidages des caches de classes différentes ne se disputent aucun verrou.
+ * Alignée sur une ligne de cache pour que les verrous voisins ne la partagent pas.
+ */
+typedef struct SlabClass {
+    pthread_mutex_t mutex;                  // Verrou de la liste
+    SlabSpan* partial;                      // Spans non pleines de la classe
+} __attribute__((aligned(64))) SlabClass;
+
+/**
+ * @brief Arène d'un nœud NUMA
+ * 
+ * Regroupe les slabs et les blocs recyclés d'un nœud : les threads d'un
+ * nœud ne se disputent que leur arène. Les spans de chaque classe de
+ * petits objets sont sous le verrou de leur SlabClass ; celui de l'arène
+ * garde les chunks et les blocs recyclés.
+ * Ordre des verrous : classe, arène, puis mutex global.
+ */
+typedef struct Arena {
+    pthread_mutex_t mutex;                  // Verrou des chunks et des blocs recyclés
+    int node;                               // Nœud NUMA de l'arène
+    MemoryBlock* recycled_bins[NUM_RECYCLE_BINS];    // Blocs recyclés par classe de taille
+    uint64_t recycled_bitmap[RECYCLE_BITMAP_WORDS];  // Classes de recyclage non vides
+    size_t recycled_bytes;                  // Octets des blocs recyclés de l'arène
+    SlabChunk* slab_chunks;                 // Chunks disposant de spans inutilisées
+    SlabClass classes[NUM_SIZE_CLASSES];    // Listes centrales des petits objets
+} Arena;
+
+/**
+ * @brief État du thread de purge en arrière-plan
+ * 
+ * Les passages sont numérotés : une mémoire inutilisée depuis au moins
+ * un passage complet (soit un intervalle) voit ses pages rendues au
+ * système par madvise, sa plage virtuelle restant réservée.
+ */
+typedef struct Scavenger {
+    pthread_t thread;                       // Thread de purge
+    pthread_mutex_t mutex;                  // Protège running et stop
+    pthread_cond_t wakeup;                  // Réveil anticipé à l'arrêt
+    bool running;                           // true si le thread est lancé
+    bool stop;                              // Demande d'arrêt du thread
+    unsigned int interval_ms;               // Intervalle entre deux passages
+    int advice;                             // VALLOC_PURGE_DONTNEED ou VALLOC_PURGE_FREE
+    uint32_t pass;                          // Nombre de passages effectués
+    size_t purged_bytes;                    // Octets rendus au système depuis l'initialisation
+} Scavenger;
+
+/**
+ * @brief Échantillon vivant du profileur de tas
+ */
+typedef struct ProfileSample {
+    void* ptr;                  // Objet échantillonné (NULL : case vide)
+    size_t size;                // Taille demandée
+    int depth;                  // Nombre d'adresses de la pile
+    void* stack[VALLOC_PROFILE_MAX_DEPTH]; // Pile d'appels, de l'appelant de l'allocateur vers main
+} ProfileSample;
+
+/**
+ * @brief État du profileur de tas par échantillonnage
+ * 
+ * En moyenne un échantillon tous les period octets alloués (tirage
+ * géométrique par thread). Les échantillons vivants sont rangés dans une
+ * table de hachage à adressage ouvert, retirés à la libération de l'objet.
+ */
+typedef struct Profiler {
+    size_t period;              // Octets moyens entre deux échantillons
+    pthread_mutex_t mutex;      // Protège la table des échantillons
+    ProfileSample* samples;     // Table des échantillons vivants
+    size_t capacity;            // Nombre de cases (puissance de 2)
+    size_t count;               // Échantillons vivants
+    size_t used;                // Cases vivantes ou supprimées
+    sem_t dump_request;         // Postée par le gestionnaire de signal
+    pthread_t dumper;           // Thread écrivant les profils demandés par signal
+    bool dumper_running;        // true si le thread d'écriture est lancé
+    bool dumper_stop;           // Demande d'arrêt du thread d'écriture
+    int dump_signal;            // Signal déclenchant une écriture
+    unsigned int dump_seq;      // Numéro du prochain fichier écrit
+    char dump_prefix[256];      // Préfixe des fichiers <prefix>.<seq>.heap
+} Profiler;
+
+/**
+ * @brief Compteurs des chemins lents, partagés entre les threads
+ * 
+ * Mis à jour atomiquement, sur des chemins qui font déjà un appel
+ * système ou prennent un verrou.
+ */
+typedef struct PoolStats {
+    uint64_t mmap_calls;                    // Projections de mémoire pour les blocs et les chunks
+    uint64_t munmap_calls;                  // Mémoire rendue par munmap
+    uint64_t mremap_calls;                  // Agrandissements par mremap
+    size_t bytes_mapped;                    // Octets actuellement projetés
+    size_t bytes_mapped_peak;               // Maximum atteint par bytes_mapped
+    uint64_t class_contention;              // Verrous de classe trouvés déjà pris
+    uint64_t arena_contention;              // Verrous d'arène trouvés déjà pris
+    uint64_t global_contention;             // Mutex global trouvé déjà pris
+    uint64_t large_reuses;                  // Grands blocs servis par une projection recyclée
+    uint64_t sized_mismatches;              // Tailles erronées détectées par free_valloc_sized
+} PoolStats;
+
+/**
+ * @brief Statistiques agrégées de l'allocateur (valloc_stats)
+ */
+typedef struct VallocStats {
+    uint64_t class_allocs[NUM_STATS_CLASSES]; // Allocations par classe de taille
+    uint64_t allocs;                        // Allocations
+    uint64_t frees;                         // Libérations
+    uint64_t cache_hits;                    // Allocations servies par un cache thread-local
+    uint64_t cache_misses;                  // Allocations manquées par un cache thread-local
+    uint64_t remote_frees;                  // Blocs rendus au cache d'un autre thread
+    uint64_t cache_refills;                 // Remplissages des caches par lots
+    uint64_t cache_flushes;                 // Vidages par lots des caches pleins
+    uint64_t bytes_requested;               // Octets demandés
+    uint64_t bytes_allocated;               // Octets servis (arrondis à la classe)
+    uint64_t mmap_calls;                    // Appels à mmap
+    uint64_t munmap_calls;                  // Appels à munmap
+    uint64_t mremap_calls;                  // Appels à mremap
+    size_t bytes_mapped;                    // Octets actuellement projetés
+    size_t bytes_mapped_peak;               // Maximum des octets projetés
+    size_t bytes_purged;                    // Octets rendus au système par la purge
+    uint64_t class_contention;              // Verrous de classe trouvés déjà pris
+    uint64_t arena_contention;              // Verrous d'arène trouvés déjà pris
+    uint64_t global_contention;             // Mutex global trouvé déjà pris
+    uint64_t large_reuses;                  // Grands blocs servis par une projection recyclée
+    uint64_t sized_mismatches;              // Tailles erronées détectées par free_valloc_sized
+    size_t bytes_recycled;                  // Octets des blocs recyclés, toutes arènes
+    size_t used_blocks;                     // Blocs de la table occupés
+    size_t recycled_blocks;                 // Blocs de la table recyclés
+    int num_threads;                        // Caches thread-locaux enregistrés
+} VallocStats;
+
 /**
  * @brief Structure principale de l'allocateur de mémoire
  * 
  * Structure centrale qui gère le système d'allocation mémoire.
  * Gère à la fois le pool global de mémoire et les caches thread-locaux.
  */
-typedef struct {
-    MemoryBlock* blocks;                    // Tableau de tous les blocs (pool global)
-    size_t total_blocks;                    // Nombre total de blocs dans le pool
+typedef struct MemoryAllocator {
+    MemoryBlock* block_chunks[BLOCK_TABLE_CHUNKS]; // Table des blocs, par tranches jamais déplacées
+    size_t block_chunk_shift;               // log2 de la taille de la première tranche
+    size_t block_chunk_count;               // Nombre de tranches allouées
+    MemoryBlock* free_slots;                // Liste des emplacements libres du tableau
+    PageMap* page_map;                      // Index adresse -> bloc
+    size_t total_blocks;                    // Capacité des tranches allouées
+    size_t next_block;                      // Emplacements déjà distribués (les suivants n'ont jamais servi)
     size_t used_blocks;                     // Nombre de blocs actuellement utilisés
     size_t recycled_blocks;                 // Nombre de blocs dans le cache de recyclage
-    pthread_mutex_t mutex;                  // Mutex global pour les opérations sur le pool
+    Arena arenas[VALLOC_MAX_NODES];         // Arènes, une par nœud NUMA
+    int num_arenas;                         // Nombre d'arènes utilisées
+    int system_nodes;                       // Nombre de nœuds NUMA du système
+    pthread_mutex_t mutex;                  // Mutex global : table des blocs, index et registre des caches
     bool initialized;                       // État d'initialisation
-    ThreadCache thread_caches[MAX_THREADS]; // Tableau des caches thread-locaux
-    int num_threads;                        // Nombre de threads actifs
+    bool profiling;                         // Profileur actif (seul test du chemin rapide)
+    ThreadCache** thread_caches[CACHE_REGISTRY_CHUNKS]; // Registre des caches, alloué par tranches
+    int num_threads;                        // Nombre d'indices de cache attribués
+    bool caches_enabled;                    // false si les caches thread-locaux sont désactivés
+    ThreadCache* free_caches;               // Caches de threads terminés, réutilisables
+    pthread_key_t cache_key;                // Clé déclenchant le vidage du cache à la fin d'un thread
+    uint64_t epoch;                         // Génération de l'allocateur (invalide les caches TLS)
+    uint32_t cache_depth[NUM_CACHE_CLASSES]; // Profondeur des caches par classe
+    size_t large_cache_limit;               // Octets recyclés conservés par arène pour les grands blocs
+    CpuCache* cpu_caches;                   // Caches par processeur (VALLOC_PERCPU), NULL sinon
+    int num_cpus;                           // Nombre de caches par processeur
+    unsigned int flags;                     // Options actives (VALLOC_HUGE_PAGES, VALLOC_HUGETLB, ...)
+    Scavenger scavenger;                    // Purge des blocs recyclés et des spans inutilisées
+    PoolStats pool_stats;                   // Compteurs des chemins lents
+    ThreadStats shared_stats;               // Activité des threads sans cache (mise à jour atomique)
+    Profiler profiler;                      // Profileur de tas par échantillonnage
 } MemoryAllocator;
 
 /**
  * @brief Initialise l'allocateur de mémoire
  * 
+ * Les caches thread-locaux sont créés à la demande pour chaque thread,
+ * sans limite liée à num_threads.
+ * 
  * @param allocator Pointeur vers la structure de l'allocateur
- * @param initial_blocks Taille initiale du pool de mémoire
- * @param num_threads Nombre de threads à supporter
+ * @param initial_blocks Capacité initiale de la table des blocs (agrandie à la demande)
+ * @param num_threads Nombre de threads attendus (0 désactive les caches thread-locaux)
  * @return int 0 en cas de succès, -1 en cas d'échec
  */
 int valloc_init(MemoryAllocator* allocator, size_t initial_blocks, int num_threads);
 
+/**
+ * @brief Initialise l'allocateur de mémoire avec des options
+ * 
+ * Avec VALLOC_HUGETLB, les chunks sont projetés en grandes pages réservées ;
+ * si le système n'en dispose pas, l'option est remplacée par VALLOC_HUGE_PAGES
+ * (visible dans allocator->flags). Sans grandes pages transparentes, le
+ * conseil madvise est sans effet et les pages de 4 KiB sont utilisées.
+ * Avec VALLOC_PERCPU, les petits objets passent par des caches par
+ * processeur (séquences restartables) ; sans rseq, l'option est retirée de
+ * allocator->flags et les caches thread-locaux sont utilisés.
+ * Avec VALLOC_DEBUG_SIZED, free_valloc_sized vérifie chaque taille annoncée.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param initial_blocks Capacité initiale de la table des blocs (agrandie à la demande)
+ * @param num_threads Nombre de threads attendus (0 désactive les caches thread-locaux)
+ * @param flags Combinaison de VALLOC_HUGE_PAGES, VALLOC_HUGETLB, VALLOC_NUMA, VALLOC_PERCPU
+ *              et VALLOC_DEBUG_SIZED
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+int valloc_init_flags(MemoryAllocator* allocator, size_t initial_blocks, int num_threads, unsigned int flags);
+
+/**
+ * @brief Impose le nombre d'arènes NUMA
+ * 
+ * Permet de simuler une topologie à plusieurs nœuds sur une machine qui
+ * n'en a qu'un : les nœuds absents du système ne sont pas liés par mbind.
+ * À appeler avant toute allocation.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param nodes Nombre d'arènes (1 à VALLOC_MAX_NODES)
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+int valloc_set_numa_nodes(MemoryAllocator* allocator, int nodes);
+
+/**
+ * @brief Impose le nœud NUMA du thread appelant
+ * 
+ * Remplace le nœud détecté par getcpu, pour tous les allocateurs.
+ * 
+ * @param node Nœud simulé (-1 pour revenir à la détection)
+ */
+void valloc_set_thread_node(int node);
+
+/**
+ * @brief Nœud NUMA de l'arène d'où provient un bloc
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Pointeur vers le bloc alloué
+ * @return int Nœud de l'arène, -1 si ptr n'a pas été alloué par l'allocateur
+ */
+int valloc_node_of(MemoryAllocator* allocator, const void* ptr);
+
 /**
  * @brief Alloue un bloc de mémoire
  * 
@@ -87,6 +542,34 @@ int valloc_init(MemoryAllocator* allocator, size_t initial_blocks, int num_threa
  */
 void* valloc_block(MemoryAllocator* allocator, size_t size);
 
+/**
+ * @brief Alloue un lot de blocs de même taille
+ * 
+ * Les petits objets sont pris dans le cache du thread (ou du processeur),
+ * puis le reste dans les spans de la classe sous un seul verrou.
+ * Les grands blocs sont alloués un par un.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param size Taille de chaque bloc
+ * @param n Nombre de blocs demandés
+ * @param out_ptrs Tableau de n pointeurs, rempli par les blocs alloués
+ * @return size_t Nombre de blocs alloués (moins de n en cas d'échec)
+ */
+size_t valloc_batch(MemoryAllocator* allocator, size_t size, size_t n, void** out_ptrs);
+
+/**
+ * @brief Alloue un bloc de mémoire aligné
+ * 
+ * Les petits objets alignés restent groupés dans les slabs ; le bloc
+ * obtenu se libère par free_valloc comme tout autre bloc.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param size Taille du bloc à allouer
+ * @param alignment Alignement demandé (puissance de 2, au plus VALLOC_MAX_ALIGNMENT)
+ * @return void* Pointeur vers le bloc aligné, NULL en cas d'échec
+ */
+void* valloc_aligned(MemoryAllocator* allocator, size_t size, size_t alignment);
+
 /**
  * @brief Recycle un bloc de mémoire pour une utilisation future
  * 
@@ -101,6 +584,7 @@ void revalloc(MemoryAllocator* allocator, void* ptr);
 /**
  * @brief Libère complètement un bloc de mémoire
  * 
+ * Un bloc alloué par un autre thread est rendu au cache de ce thread.
  * Retourne la mémoire au système si elle ne peut pas être mise en cache.
  * 
  * @param allocator Pointeur vers la structure de l'allocateur
@@ -108,6 +592,60 @@ void revalloc(MemoryAllocator* allocator, void* ptr);
  */
 void free_valloc(MemoryAllocator* allocator, void* ptr);
 
+/**
+ * @brief Libère un lot de blocs
+ * 
+ * Les blocs vont au cache du thread, ou à celui de leur propriétaire ;
+ * ceux qui n'y tiennent pas retournent aux listes centrales en un seul
+ * passage, un verrou par classe ou par arène concernée.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptrs Blocs à libérer (les pointeurs NULL sont ignorés)
+ * @param n Nombre de pointeurs
+ */
+void free_valloc_batch(MemoryAllocator* allocator, void** ptrs, size_t n);
+
+/**
+ * @brief Libère un petit objet dont la taille est connue
+ * 
+ * Jusqu'à SLAB_MAX_SIZE, la span de l'objet se déduit de son adresse,
+ * sans la table des blocs : seuls le propriétaire et la classe réelle y
+ * sont lus, pour rendre l'objet à son thread et à la bonne classe (un
+ * objet réduit en place par valloc_realloc garde la sienne). Les grands
+ * blocs passent par free_valloc. Les blocs de valloc_aligned dont
+ * l'alignement dépasse SLAB_MAX_SIZE doivent être libérés par free_valloc.
+ * Avec VALLOC_DEBUG_SIZED, une taille d'une autre classe que l'objet est
+ * comptée dans sized_mismatches et le bloc libéré d'après ses
+ * métadonnées ; un bloc de valloc_aligned est alors annoncé avec sa
+ * taille utilisable (valloc_usable_size).
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Pointeur vers le bloc à libérer
+ * @param size Taille demandée à l'allocation (ou au dernier valloc_realloc)
+ */
+void free_valloc_sized(MemoryAllocator* allocator, void* ptr, size_t size);
+
+/**
+ * @brief Taille réellement utilisable d'un bloc alloué
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Pointeur vers le bloc alloué
+ * @return size_t Taille utilisable, 0 si ptr n'a pas été alloué par l'allocateur
+ */
+size_t valloc_usable_size(MemoryAllocator* allocator, const void* ptr);
+
+/**
+ * @brief Redimensionne un bloc alloué, en place quand c'est possible
+ * 
+ * Les grands blocs sont agrandis par mremap, sans copie du contenu.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param ptr Bloc à redimensionner (NULL : équivaut à valloc_block)
+ * @param size Nouvelle taille (0 : équivaut à free_valloc)
+ * @return void* Bloc redimensionné, NULL en cas d'échec (ptr reste alors valide)
+ */
+void* valloc_realloc(MemoryAllocator* allocator, void* ptr, size_t size);
+
 /**
  * @brief Effectue le nettoyage des blocs recyclés
  * 
@@ -117,6 +655,111 @@ void free_valloc(MemoryAllocator* allocator, void* ptr);
  */
 void valloc_cleanup(MemoryAllocator* allocator);
 
+/**
+ * @brief Effectue un passage de purge
+ * 
+ * Rend au système (madvise) les pages des blocs recyclés et des spans
+ * inutilisées depuis le passage précédent, sans libérer leurs plages
+ * virtuelles : leur réutilisation ne demande aucun appel système.
+ * Peut être appelée directement (purge découpée dans le temps) ou
+ * par le thread lancé par valloc_scavenger_start.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @return size_t Nombre d'octets rendus au système par ce passage
+ */
+size_t valloc_scavenge(MemoryAllocator* allocator);
+
+/**
+ * @brief Lance le thread de purge en arrière-plan
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param interval_ms Intervalle entre deux passages, en millisecondes
+ * @param advice VALLOC_PURGE_DONTNEED ou VALLOC_PURGE_FREE
+ * @return int 0 en cas de succès, -1 en cas d'échec ou si le thread est déjà lancé
+ */
+int valloc_scavenger_start(MemoryAllocator* allocator, unsigned int interval_ms, int advice);
+
+/**
+ * @brief Arrête le thread de purge et attend sa terminaison
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ */
+void valloc_scavenger_stop(MemoryAllocator* allocator);
+
+/**
+ * @brief Relève les statistiques de l'allocateur
+ * 
+ * Additionne les compteurs de tous les caches thread-locaux et ceux des
+ * chemins lents. Utilisable pendant que les threads allouent : chaque
+ * compteur est lu atomiquement, l'ensemble n'est pas un instantané exact.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param stats Statistiques remplies
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+int valloc_stats(MemoryAllocator* allocator, VallocStats* stats);
+
+/**
+ * @brief Affiche les statistiques de l'allocateur
+ * 
+ * Totaux, détail par classe de taille et activité de chaque cache thread-local.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param stream Flux de sortie (stdout si NULL)
+ */
+void valloc_stats_print(MemoryAllocator* allocator, FILE* stream);
+
+/**
+ * @brief Active le profileur de tas
+ * 
+ * Environ une allocation tous les period octets est échantillonnée avec
+ * sa pile d'appels ; désactivé, le profileur ne coûte qu'un test par
+ * allocation.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param period Nombre moyen d'octets alloués entre deux échantillons
+ *        (0 : VALLOC_PROFILE_DEFAULT_PERIOD)
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+int valloc_profile_start(MemoryAllocator* allocator, size_t period);
+
+/**
+ * @brief Arrête l'échantillonnage
+ * 
+ * Les échantillons encore vivants restent dans les profils jusqu'à leur libération.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ */
+void valloc_profile_stop(MemoryAllocator* allocator);
+
+/**
+ * @brief Écrit le profil des échantillons vivants
+ * 
+ * VALLOC_PROFILE_TEXT : piles regroupées, triées par octets estimés.
+ * VALLOC_PROFILE_PPROF : format de tas historique lu par pprof
+ * (heap_v2, suivi de MAPPED_LIBRARIES pour la symbolisation).
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param stream Flux de sortie
+ * @param format VALLOC_PROFILE_TEXT ou VALLOC_PROFILE_PPROF
+ * @return int Nombre d'échantillons écrits, -1 en cas d'échec
+ */
+int valloc_profile_dump(MemoryAllocator* allocator, FILE* stream, int format);
+
+/**
+ * @brief Écrit un profil pprof à chaque réception d'un signal
+ * 
+ * Le gestionnaire ne fait que réveiller un thread dédié, qui écrit
+ * <prefix>.<seq>.heap. Un seul allocateur par processus peut être
+ * associé à un signal.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param signo Signal déclencheur (par exemple SIGUSR2)
+ * @param prefix Préfixe des fichiers écrits
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+int valloc_profile_signal(MemoryAllocator* allocator, int signo, const char* prefix);
+
 /**
  * @brief Détruit l'allocateur et libère toute la mémoire
  * 
@@ -124,17 +767,48 @@ void valloc_cleanup(MemoryAllocator* allocator);
  */
 void valloc_destroy(MemoryAllocator* allocator);
 
+/**
+ * @brief Configure la profondeur des caches thread-locaux pour une taille
+ * 
+ * Fixe le nombre maximum de blocs de la classe de size conservés par
+ * chaque thread. À appeler avant que les threads utilisent l'allocateur.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param size Taille représentative de la classe
+ * @param depth Nombre maximum de blocs (0 désactive le cache pour la classe)
+ * @return int 0 en cas de succès, -1 si la taille n'est pas mise en cache
+ */
+int valloc_set_cache_depth(MemoryAllocator* allocator, size_t size, int depth);
+
+/**
+ * @brief Borne le cache des grandes projections
+ * 
+ * Un bloc de plus de CACHE_MAX_SIZE libéré reste projeté, pour servir une
+ * demande suivante, tant que les blocs recyclés de son arène ne dépassent
+ * pas max_bytes ; au-delà, il est rendu au système.
+ * 
+ * @param allocator Pointeur vers la structure de l'allocateur
+ * @param max_bytes Octets recyclés par arène (0 : grands blocs toujours rendus)
+ * @return int 0 en cas de succès, -1 en cas d'échec
+ */
+int valloc_set_large_cache(MemoryAllocator* allocator, size_t max_bytes);
+
 /**
  * @brief Obtient le cache thread-local pour le thread actuel
  * 
+ * Enregistre un cache pour le thread lors du premier appel.
+ * 
  * @param allocator Pointeur vers la structure de l'allocateur
- * @return ThreadCache* Pointeur vers le cache thread-local
+ * @return ThreadCache* Pointeur vers le cache thread-local, NULL si les caches
+ *         sont désactivés ou si le cache n'a pas pu être créé
  */
 ThreadCache* get_thread_cache(MemoryAllocator* allocator);
 
 /**
  * @brief Alloue de la mémoire depuis le cache thread-local
  * 
+ * Réservée au thread propriétaire du cache.
+ * 
  * @param cache Pointeur vers le cache thread-local
  * @param size Taille du bloc de mémoire à allouer
  * @return void* Pointeur vers la mémoire allouée, NULL en cas d'échec
@@ -144,10 +818,26 @@ void* cache_allocate(ThreadCache* cache, size_t size);
 /**
  * @brief Libère de la mémoire vers le cache thread-local
  * 
+ * Réservée au thread propriétaire du cache.
+ * 
  * @param cache Pointeur vers le cache thread-local
  * @param ptr Pointeur vers le bloc de mémoire à libérer
  * @param size Taille du bloc de mémoire à libérer
+ * @return bool true si le bloc a été mis en cache, false si le cache est plein
+ */
+bool cache_free(ThreadCache* cache, void* ptr, size_t size);
+
+/**
+ * @brief Rend un bloc au cache d'un autre thread
+ * 
+ * Utilisable depuis n'importe quel thread, sans verrou. Le bloc est
+ * empilé sur le canal atomique du cache et récupéré par son propriétaire
+ * lors de sa prochaine allocation.
+ * 
+ * @param cache Pointeur vers le cache destinataire
+ * @param ptr Pointeur vers le bloc (au moins sizeof(CacheBlock) octets)
+ * @param size Taille du bloc
  */
-void cache_free(ThreadCache* cache, void* ptr, size_t size);
+void cache_free_remote(ThreadCache* cache, void* ptr, size_t size);
 
 #endif // VALLOC_H
@@ -0,0 +1,231 @@
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "valloc.h"
+
+/*
+ * Remplacement de malloc/free de la libc par valloc (libvalloc.so).
+ *
+ * Utilisation : LD_PRELOAD=./libvalloc.so programme
+ *
+ * Un allocateur global unique est initialisé au premier appel. Ses
+ * métadonnées sont prises à mmap : l'initialisation n'appelle jamais
+ * malloc, et peut donc avoir lieu pendant le démarrage de la libc.
+ *
+ * Profil du tas : VALLOC_PROFILE=<période en octets> active
+ * l'échantillonnage, VALLOC_PROFILE_PREFIX=<préfixe> écrit un profil pprof
+ * <préfixe>.NNNN.heap à chaque SIGUSR2.
+ *
+ * Caches par processeur : VALLOC_PERCPU=1 les active à la place des caches
+ * thread-locaux (ignoré sans rseq).
+ */
+
+// Capacité initiale de la table des blocs (agrandie à la demande)
+#define PRELOAD_INITIAL_BLOCKS 1024
+// Nombre de threads attendus (indicatif, les caches sont créés à la demande)
+#define PRELOAD_THREADS 64
+
+#define VALLOC_PAGE_SIZE ((size_t)1 << VALLOC_PAGE_SHIFT)
+
+static MemoryAllocator global_allocator;
+static pthread_once_t global_once = PTHREAD_ONCE_INIT;
+static bool global_ready = false;
+
+/**
+ * @brief Verrouille l'allocateur avant fork
+ *
+ * Le fils hérite ainsi d'un allocateur cohérent, même si un autre
+ * thread était au milieu d'un chemin lent. Ordre des verrous : profileur,
+ * classes, arènes, puis mutex global.
+ */
+static void preload_prepare(void) {
+    pthread_mutex_lock(&global_allocator.profiler.mutex);
+    for (int i = 0; i < VALLOC_MAX_NODES; i++) {
+        for (int c = 0; c < NUM_SIZE_CLASSES; c++) {
+            pthread_mutex_lock(&global_allocator.arenas[i].classes[c].mutex);
+        }
+    }
+    for (int i = 0; i < VALLOC_MAX_NODES; i++) {
+        pthread_mutex_lock(&global_allocator.arenas[i].mutex);
+    }
+    pthread_mutex_lock(&global_allocator.mutex);
+}
+
+/**
+ * @brief Déverrouille l'allocateur après fork, dans le père et dans le fils
+ */
+static void preload_release(void) {
+    pthread_mutex_unlock(&global_allocator.mutex);
+    for (int i = VALLOC_MAX_NODES - 1; i >= 0; i--) {
+        pthread_mutex_unlock(&global_allocator.arenas[i].mutex);
+    }
+    for (int i = VALLOC_MAX_NODES - 1; i >= 0; i--) {
+        for (int c = NUM_SIZE_CLASSES - 1; c >= 0; c--) {
+            pthread_mutex_unlock(&global_allocator.arenas[i].classes[c].mutex);
+        }
+    }
+    pthread_mutex_unlock(&global_allocator.profiler.mutex);
+}
+
+/**
+ * @brief Initialise l'allocateur global (une seule fois)
+ *
+ * Une arène par nœud NUMA : sur une machine à un seul nœud, rien ne change.
+ * getenv n'alloue pas : il peut être appelé depuis le premier malloc.
+ */
+static void preload_init(void) {
+    unsigned int flags = VALLOC_NUMA;
+    const char* percpu = getenv("VALLOC_PERCPU");
+    if (percpu && percpu[0] != '\0' && percpu[0] != '0') flags |= VALLOC_PERCPU;
+    if (valloc_init_flags(&global_allocator, PRELOAD_INITIAL_BLOCKS, PRELOAD_THREADS, flags) != 0) return;
+    pthread_atfork(preload_prepare, preload_release, preload_release);
+    global_ready = true;
+}
+
+/**
+ * @brief Retourne l'allocateur global, initialisé à la demande
+ *
+ * @return MemoryAllocator* Allocateur global, NULL si l'initialisation a échoué
+ */
+static MemoryAllocator* preload_allocator(void) {
+    if (__builtin_expect(!__atomic_load_n(&global_ready, __ATOMIC_ACQUIRE), 0)) {
+        pthread_once(&global_once, preload_init);
+        if (!global_ready) return NULL;
+    }
+    return &global_allocator;
+}
+
+/**
+ * @brief Active le profileur selon l'environnement, au chargement de la bibliothèque
+ *
+ * Dans un constructeur plutôt que dans preload_init : le thread d'écriture
+ * des profils ne peut pas être créé depuis le premier malloc.
+ */
+__attribute__((constructor)) static void preload_profile_init(void) {
+    const char* period = getenv("VALLOC_PROFILE");
+    if (period == NULL) return;
+
+    MemoryAllocator* allocator = preload_allocator();
+    if (allocator == NULL) return;
+    valloc_profile_start(allocator, (size_t)strtoull(period, NULL, 10));
+
+    const char* prefix = getenv("VALLOC_PROFILE_PREFIX");
+    if (prefix) valloc_profile_signal(allocator, SIGUSR2, prefix);
+}
+
+/**
+ * @brief Alloue un bloc aligné
+ *
+ * @param alignment Alignement demandé (puissance de 2)
+ * @param size Taille demandée
+ * @return void* Bloc aligné, NULL en cas d'échec
+ */
+static void* preload_aligned(size_t alignment, size_t size) {
+    MemoryAllocator* allocator = preload_allocator();
+    if (allocator == NULL) return NULL;
+    return valloc_aligned(allocator, size ? size : 1, alignment);
+}
+
+void* malloc(size_t size) {
+    MemoryAllocator* allocator = preload_allocator();
+    if (allocator == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    void* ptr = valloc_block(allocator, size ? size : 1);
+    if (ptr == NULL) errno = ENOMEM;
+    return ptr;
+}
+
+void free(void* ptr) {
+    if (ptr == NULL) return;
+    MemoryAllocator* allocator = preload_allocator();
+    if (allocator) free_valloc(allocator, ptr);
+}
+
+void* calloc(size_t nmemb, size_t size) {
+    size_t total;
+    if (__builtin_mul_overflow(nmemb, size, &total)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    MemoryAllocator* allocator = preload_allocator();
+    if (allocator == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    // Pas malloc + memset : le compilateur les fusionnerait en un appel récursif à calloc
+    void* ptr = valloc_block(allocator, total ? total : 1);
+    if (ptr == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    memset(ptr, 0, total);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) {
+    if (ptr == NULL) return malloc(size);
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+
+    // Bloc inconnu ou mémoire épuisée : l'ancien bloc reste valide
+    void* new_ptr = valloc_realloc(preload_allocator(), ptr, size);
+    if (new_ptr == NULL) errno = ENOMEM;
+    return new_ptr;
+}
+
+// reallocarray de la glibc appelle son propre realloc sans passer par la PLT
+void* reallocarray(void* ptr, size_t nmemb, size_t size) {
+    size_t total;
+    if (__builtin_mul_overflow(nmemb, size, &total)) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return realloc(ptr, total);
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size) {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) return EINVAL;
+
+    void* ptr = preload_aligned(alignment, size);
+    if (ptr == NULL) return ENOMEM;
+    *memptr = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    void* ptr = preload_aligned(alignment, size);
+    if (ptr == NULL) errno = ENOMEM;
+    return ptr;
+}
+
+void* memalign(size_t alignment, size_t size) {
+    return aligned_alloc(alignment, size);
+}
+
+void* valloc(size_t size) {
+    return aligned_alloc(VALLOC_PAGE_SIZE, size);
+}
+
+void* pvalloc(size_t size) {
+    return aligned_alloc(VALLOC_PAGE_SIZE, (size + VALLOC_PAGE_SIZE - 1) & ~(VALLOC_PAGE_SIZE - 1));
+}
+
+size_t malloc_usable_size(void* ptr) {
+    if (ptr == NULL) return 0;
+    MemoryAllocator* allocator = preload_allocator();
+    return allocator ? valloc_usable_size(allocator, ptr) : 0;
+}
@@ -1,36 +1,88 @@
+#include <stdlib.h>  // Déclare le valloc de la glibc : ne doit pas entrer en conflit
 #include "valloc.h"
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
+
+#define NUM_THREADS 4
+#define THREAD_ALLOCATIONS 1000
+
+static memory_manager_t manager;
+
+// Chaque thread écrit son numéro dans ses blocs et vérifie qu'aucun autre ne les a touchés
+static void* thread_test(void* arg) {
+    int id = (int)(size_t)arg;
+    char* blocks[64];
+    for (int round = 0; round < THREAD_ALLOCATIONS / 64; round++) {
+        for (int i = 0; i < 64; i++) {
+            size_t size = 8 + (size_t)((i * 37 + id) % 200);
+            blocks[i] = (char*)valloc_alloc(&manager, size);
+            if (blocks[i] == NULL) return (void*)1;
+            memset(blocks[i], id, size);
+        }
+        for (int i = 0; i < 64; i++) {
+            size_t size = 8 + (size_t)((i * 37 + id) % 200);
+            for (size_t j = 0; j < size; j++) {
+                if (blocks[i][j] != (char)id) return (void*)1;
+            }
+            vafree(&manager, blocks[i]);
+        }
+    }
+    return NULL;
+}
+
+#define BURST_BLOCKS 8192
+// Blocs de 4 Ko d'un chunk : VA_HEAP_CHUNK_SIZE / VA_MAX_BLOCK_SIZE, moins celui de l'en-tête
+#define CHUNK_LARGE_BLOCKS (VA_HEAP_CHUNK_SIZE / VA_MAX_BLOCK_SIZE - 1)
+
+// Rafale de petits blocs : le tas est découpé sur plusieurs chunks, puis libéré.
+// Le cache du thread est vidé à sa terminaison.
+static void* burst_test(void* arg) {
+    memory_manager_t* heap = (memory_manager_t*)arg;
+    static void* blocks[BURST_BLOCKS];
+    for (int i = 0; i < BURST_BLOCKS; i++) {
+        blocks[i] = valloc_alloc(heap, 16);
+        if (blocks[i] == NULL) return (void*)1;
+    }
+    for (int i = 0; i < BURST_BLOCKS; i++) {
+        vafree(heap, blocks[i]);
+    }
+    return NULL;
+}
 
 int main() {
     printf("Test de l'allocateur mémoire personnalisé\n");
+    if (init_vallocator(&manager) != 0) {
+        printf("❌ Échec de l'initialisation\n");
+        return 1;
+    }
 
     // Test 1: Allocation simple
     printf("\nTest 1: Allocation simple\n");
-    char* str = (char*)my_malloc(16);
+    char* str = (char*)valloc_alloc(&manager, 16);
     if (str == NULL) {
         printf("❌ Échec de l'allocation\n");
         return 1;
     }
     strcpy(str, "Valloc");
     printf("✅ Vallocation réussie: %s\n", str);
-    my_free(str);
+    vafree(&manager, str);
 
     // Test 2: Allocation de taille nulle
     printf("\nTest 2: Allocation de taille nulle\n");
-    void* null_ptr = my_malloc(0);
+    void* null_ptr = valloc_alloc(&manager, 0);
     if (null_ptr == NULL) {
         printf("✅ Vallocation de taille nulle correctement gérée\n");
     } else {
         printf("❌ L'allocation de taille nulle devrait retourner NULL\n");
-        my_free(null_ptr);
+        vafree(&manager, null_ptr);
     }
 
     // Test 3: Allocation et libération multiple
     printf("\nTest 3: Allocations multiples\n");
     int* numbers[5];
     for (int i = 0; i < 5; i++) {
-        numbers[i] = (int*)my_malloc(sizeof(int));
+        numbers[i] = (int*)valloc_alloc(&manager, sizeof(int));
         if (numbers[i] == NULL) {
             printf("❌ Échec de l'allocation %d\n", i);
             return 1;
@@ -40,10 +92,94 @@ int main() {
     
     for (int i = 0; i < 5; i++) {
         printf("Nombre %d: %d\n", i, *numbers[i]);
-        my_free(numbers[i]);
+        vafree(&manager, numbers[i]);
     }
     printf("✅ Vallocations et libérations multiples réussies\n");
 
+    // Test 4: Threads concurrents sur le même gestionnaire
+    printf("\nTest 4: Threads concurrents\n");
+    pthread_t threads[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_create(&threads[i], NULL, thread_test, (void*)(size_t)(i + 1));
+    }
+    int failed = 0;
+    for (int i = 0; i < NUM_THREADS; i++) {
+        void* result;
+        pthread_join(threads[i], &result);
+        if (result != NULL) failed = 1;
+    }
+    if (failed) {
+        printf("❌ Blocs corrompus entre threads\n");
+        return 1;
+    }
+    printf("✅ Vallocations concurrentes réussies\n");
+
+    // Test 5: Deux gestionnaires indépendants
+    printf("\nTest 5: Gestionnaires indépendants\n");
+    memory_manager_t other;
+    if (init_vallocator(&other) != 0) {
+        printf("❌ Échec de l'initialisation\n");
+        return 1;
+    }
+    char* a = (char*)valloc_alloc(&manager, 100);
+    char* b = (char*)valloc_alloc(&other, 100);
+    if (a == NULL || b == NULL) {
+        printf("❌ Échec de l'allocation\n");
+        return 1;
+    }
+    strcpy(a, "manager");
+    strcpy(b, "other");
+    printf("✅ %s / %s\n", a, b);
+    vafree(&manager, a);
+    vafree(&other, b);
+    cleanup_vallocator(&other);
+
+    // Test 6: Fusion des compagnons après une rafale de petites allocations :
+    // tous les chunks projetés pendant la rafale redeviennent des blocs de 4 Ko
+    printf("\nTest 6: Fusion des compagnons\n");
+    memory_manager_t heap;
+    if (init_vallocator(&heap) != 0) {
+        printf("❌ Échec de l'initialisation\n");
+        return 1;
+    }
+    pthread_t burst;
+    void* burst_result;
+    pthread_create(&burst, NULL, burst_test, &heap);
+    pthread_join(burst, &burst_result);
+    size_t chunks = heap.chunk_count;
+    printf("Tas agrandi à %zu chunks, fragmentation %.2f\n", chunks, vallocator_fragmentation(&heap));
+
+    size_t count = chunks * CHUNK_LARGE_BLOCKS;
+    static void* large[BURST_BLOCKS];
+    for (size_t i = 0; i < count; i++) {
+        large[i] = valloc_alloc(&heap, VA_MAX_BLOCK_SIZE - 64);
+        if (large[i] == NULL) burst_result = (void*)1;
+    }
+    if (burst_result != NULL || chunks < 2 || heap.chunk_count != chunks) {
+        printf("❌ Tas resté fragmenté (%zu chunks)\n", heap.chunk_count);
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        vafree(&heap, large[i]);
+    }
+    printf("✅ Blocs fusionnés\n");
+
+    // Test 7: Grands blocs, rendus par vafree ou par le nettoyage
+    printf("\nTest 7: Grands blocs\n");
+    char* big[3];
+    for (int i = 0; i < 3; i++) {
+        big[i] = (char*)valloc_alloc(&heap, 100000 * (size_t)(i + 1));
+        if (big[i] == NULL) {
+            printf("❌ Échec de l'allocation\n");
+            return 1;
+        }
+        memset(big[i], i, 100000 * (size_t)(i + 1));
+    }
+    vafree(&heap, big[1]);
+    cleanup_vallocator(&heap);
+    printf("✅ Grands blocs libérés\n");
+
+    cleanup_vallocator(&manager);
     printf("\nTous les tests sont terminés\n");
     return 0;
 }
@@ -11,6 +11,76 @@
 #define MIN_SIZE 16       // 16 bytes
 #define MAX_SIZE 1048576  // 1MB
 #define INITIAL_BLOCKS 10000
+#define LATENCY_BLOCK_SIZE 64
+#define LATENCY_SAMPLES 1000
+
+// Mesure de la latence de libération en fonction du nombre de blocs vivants :
+// elle doit rester constante de 1k à 1M blocs grâce à l'index adresse -> bloc
+static int test_free_latency(const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        perror("Erreur lors de l'ouverture du fichier");
+        return -1;
+    }
+    fprintf(file, "live_blocks,operation,time\n");
+
+    size_t live_counts[] = {1000, 10000, 100000, 1000000};
+    int num_counts = sizeof(live_counts) / sizeof(live_counts[0]);
+
+    for (int c = 0; c < num_counts; c++) {
+        size_t n = live_counts[c];
+        MemoryAllocator allocator;
+        if (valloc_init(&allocator, n, 1) != 0) {
+            fprintf(stderr, "Erreur d'initialisation de l'allocateur\n");
+            fclose(file);
+            return -1;
+        }
+
+        void** ptrs = malloc(n * sizeof(void*));
+        if (!ptrs) {
+            valloc_destroy(&allocator);
+            fclose(file);
+            return -1;
+        }
+        for (size_t i = 0; i < n; i++) {
+            ptrs[i] = valloc_block(&allocator, LATENCY_BLOCK_SIZE);
+            if (!ptrs[i]) {
+                fprintf(stderr, "Erreur d'allocation du bloc %zu/%zu\n", i, n);
+                free(ptrs);
+                valloc_destroy(&allocator);
+                fclose(file);
+                return -1;
+            }
+        }
+
+        // Échantillon réparti sur tout le pool, un bloc sur deux pour chaque opération
+        size_t samples = n / 2 < LATENCY_SAMPLES ? n / 2 : LATENCY_SAMPLES;
+        size_t stride = n / samples;
+
+        double start_time = get_time();
+        for (size_t k = 0; k < samples; k++) {
+            free_valloc(&allocator, ptrs[k * stride]);
+        }
+        double free_time = (get_time() - start_time) / samples;
+
+        start_time = get_time();
+        for (size_t k = 0; k < samples; k++) {
+            revalloc(&allocator, ptrs[k * stride + 1]);
+        }
+        double revalloc_time = (get_time() - start_time) / samples;
+
+        fprintf(file, "%zu,free_valloc,%.9f\n", n, free_time);
+        fprintf(file, "%zu,revalloc,%.9f\n", n, revalloc_time);
+        printf("%8zu blocs vivants : free_valloc %.0f ns, revalloc %.0f ns\n",
+               n, free_time * 1e9, revalloc_time * 1e9);
+
+        free(ptrs);
+        valloc_destroy(&allocator);
+    }
+
+    fclose(file);
+    return 0;
+}
 
 int main() {
     // Initialisation de l'allocateur
@@ -100,5 +170,10 @@ int main() {
     valloc_destroy(&allocator);
 
     printf("Tests terminés. Résultats sauvegardés dans basic_performance_results.csv\n");
+
+    if (test_free_latency("free_latency_results.csv") != 0) {
+        return 1;
+    }
+    printf("Latences de libération sauvegardées dans free_latency_results.csv\n");
     return 0;
 }
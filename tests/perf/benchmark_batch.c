@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../../src/valloc.h"
+
+#define TOTAL_OPS 4000000
+#define OBJECT_SIZE 64
+#define INITIAL_BLOCKS 1000
+#define CSV_FILE "benchmark_batch.csv"
+
+// Modes mesurés : avec caches thread-locaux, puis listes centrales seules
+enum { MODE_CACHE, MODE_CENTRAL, NUM_MODES };
+static const char* mode_names[NUM_MODES] = {"cache", "central"};
+
+// Tailles de lot comparées
+static const int batch_sizes[] = {32, 64, 128, 256};
+#define NUM_SIZES (int)(sizeof(batch_sizes) / sizeof(batch_sizes[0]))
+#define MAX_BATCH 256
+
+// Temps réel en nanosecondes
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Lots alloués puis libérés un bloc à la fois
+int run_single(MemoryAllocator* allocator, int batch) {
+    void* ptrs[MAX_BATCH];
+    for (int done = 0; done < TOTAL_OPS; done += batch) {
+        for (int i = 0; i < batch; i++) {
+            ptrs[i] = valloc_block(allocator, OBJECT_SIZE);
+            if (!ptrs[i]) return -1;
+            *(char*)ptrs[i] = (char)i;
+        }
+        for (int i = 0; i < batch; i++) free_valloc(allocator, ptrs[i]);
+    }
+    return 0;
+}
+
+// Mêmes lots, par valloc_batch et free_valloc_batch
+int run_batch(MemoryAllocator* allocator, int batch) {
+    void* ptrs[MAX_BATCH];
+    for (int done = 0; done < TOTAL_OPS; done += batch) {
+        if (valloc_batch(allocator, OBJECT_SIZE, (size_t)batch, ptrs) != (size_t)batch) return -1;
+        for (int i = 0; i < batch; i++) *(char*)ptrs[i] = (char)i;
+        free_valloc_batch(allocator, ptrs, (size_t)batch);
+    }
+    return 0;
+}
+
+// Débit en millions d'opérations (allocation et libération) par seconde
+double measure(int mode, int batch, int batched) {
+    MemoryAllocator allocator;
+    if (valloc_init(&allocator, INITIAL_BLOCKS, mode == MODE_CACHE ? 1 : 0) != 0) return -1;
+    double start_time = get_time();
+    int result = batched ? run_batch(&allocator, batch) : run_single(&allocator, batch);
+    double elapsed = get_time() - start_time;
+    valloc_destroy(&allocator);
+    if (result != 0) return -1;
+    return (double)(TOTAL_OPS / batch * batch) / elapsed * 1e3;
+}
+
+int main() {
+    FILE* csv_file = fopen(CSV_FILE, "w");
+    if (!csv_file) {
+        printf("Failed to open CSV file\n");
+        return 1;
+    }
+    fprintf(csv_file, "mode,batch_size,single_mops_per_sec,batch_mops_per_sec,speedup\n");
+
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+        for (int s = 0; s < NUM_SIZES; s++) {
+            int batch = batch_sizes[s];
+            double single = measure(mode, batch, 0);
+            double batched = measure(mode, batch, 1);
+            if (single < 0 || batched < 0) {
+                printf("Allocation failed\n");
+                return 1;
+            }
+            printf("%-7s lots de %3d : %6.2f Mop/s un à un, %6.2f Mop/s par lot (x%.2f)\n",
+                   mode_names[mode], batch, single, batched, batched / single);
+            fprintf(csv_file, "%s,%d,%.3f,%.3f,%.3f\n", mode_names[mode], batch, single, batched,
+                    batched / single);
+        }
+    }
+
+    fclose(csv_file);
+    printf("Benchmark completed. Results written to %s\n", CSV_FILE);
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include "../../src/valloc.h"
+
+#define NUM_THREADS 4
+#define NUM_ITERATIONS 10000000
+#define BLOCK_SIZE 64
+#define INITIAL_BLOCKS 1000
+#define CSV_FILE "benchmark_cache_fastpath.csv"
+
+// Modes mesurés pour une paire allocation/libération
+enum { MODE_LOCKFREE, MODE_MUTEX, MODE_VALLOC, MODE_SIZED, NUM_MODES };
+static const char* mode_names[NUM_MODES] = {"lockfree", "mutex", "valloc", "sized"};
+
+typedef struct {
+    int mode;
+    double ns_per_op;
+} ThreadData;
+
+MemoryAllocator allocator;
+
+// Temps CPU du thread en nanosecondes (insensible au partage des cœurs)
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void* benchmark_thread(void* arg) {
+    ThreadData* data = (ThreadData*)arg;
+    ThreadCache* cache = get_thread_cache(&allocator);
+    // Mutex propre au thread : reproduit le verrouillage de l'ancien ThreadCache
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    void* ptr = valloc_block(&allocator, BLOCK_SIZE);
+
+    double start_time = get_time();
+    switch (data->mode) {
+    case MODE_LOCKFREE:
+        for (int i = 0; i < NUM_ITERATIONS; i++) {
+            cache_free(cache, ptr, BLOCK_SIZE);
+            ptr = cache_allocate(cache, BLOCK_SIZE);
+        }
+        break;
+    case MODE_MUTEX:
+        for (int i = 0; i < NUM_ITERATIONS; i++) {
+            pthread_mutex_lock(&mutex);
+            cache_free(cache, ptr, BLOCK_SIZE);
+            pthread_mutex_unlock(&mutex);
+            pthread_mutex_lock(&mutex);
+            ptr = cache_allocate(cache, BLOCK_SIZE);
+            pthread_mutex_unlock(&mutex);
+        }
+        break;
+    case MODE_VALLOC:
+        for (int i = 0; i < NUM_ITERATIONS; i++) {
+            free_valloc(&allocator, ptr);
+            ptr = valloc_block(&allocator, BLOCK_SIZE);
+        }
+        break;
+    case MODE_SIZED:
+        for (int i = 0; i < NUM_ITERATIONS; i++) {
+            free_valloc_sized(&allocator, ptr, BLOCK_SIZE);
+            ptr = valloc_block(&allocator, BLOCK_SIZE);
+        }
+        break;
+    }
+    double end_time = get_time();
+
+    free_valloc(&allocator, ptr);
+    data->ns_per_op = (end_time - start_time) / NUM_ITERATIONS;
+    return NULL;
+}
+
+int main() {
+    pthread_t threads[NUM_THREADS];
+    ThreadData thread_data[NUM_THREADS];
+
+    FILE* csv_file = fopen(CSV_FILE, "w");
+    if (!csv_file) {
+        printf("Failed to open CSV file\n");
+        return 1;
+    }
+    fprintf(csv_file, "mode,thread_id,ns_per_op\n");
+
+    if (valloc_init(&allocator, INITIAL_BLOCKS, MAX_THREADS) != 0) {
+        printf("Failed to initialize allocator\n");
+        return 1;
+    }
+
+    // Une paire allocation/libération par itération, chaque thread sur son propre cache
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+        for (int i = 0; i < NUM_THREADS; i++) {
+            thread_data[i].mode = mode;
+            if (pthread_create(&threads[i], NULL, benchmark_thread, &thread_data[i]) != 0) {
+                printf("Failed to create thread %d\n", i);
+                return 1;
+            }
+        }
+
+        double total = 0;
+        for (int i = 0; i < NUM_THREADS; i++) {
+            pthread_join(threads[i], NULL);
+            fprintf(csv_file, "%s,%d,%.3f\n", mode_names[mode], i, thread_data[i].ns_per_op);
+            total += thread_data[i].ns_per_op;
+        }
+        printf("%-8s : %.2f ns par paire allocation/libération\n", mode_names[mode], total / NUM_THREADS);
+    }
+
+    valloc_destroy(&allocator);
+    fclose(csv_file);
+
+    printf("Benchmark completed. Results written to %s\n", CSV_FILE);
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "../../src/valloc.h"
+
+#define NUM_NODES (4 * 1024 * 1024)
+#define NUM_STEPS (20 * 1000 * 1000)
+#define INITIAL_BLOCKS 1000
+#define CSV_FILE "benchmark_huge_pages.csv"
+
+// Nœud d'une liste chaînée parcourue dans un ordre aléatoire (une ligne de cache)
+typedef struct Node {
+    struct Node* next;
+    char pad[56];
+} Node;
+
+// Modes mesurés : pages de 4 KiB, grandes pages transparentes, grandes pages réservées
+static const unsigned int mode_flags[] = {0, VALLOC_HUGE_PAGES, VALLOC_HUGETLB};
+static const char* mode_names[] = {"4k", "thp", "hugetlb"};
+#define NUM_MODES (sizeof(mode_flags) / sizeof(mode_flags[0]))
+
+// Temps CPU du thread en nanosecondes
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Ouvre un compteur matériel du thread courant, -1 s'il est indisponible
+int open_counter(unsigned int type, unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+long long read_counter(int fd) {
+    long long value = -1;
+    if (fd >= 0 && read(fd, &value, sizeof(value)) != sizeof(value)) value = -1;
+    return value;
+}
+
+// Mémoire anonyme couverte par des grandes pages transparentes, en Ko
+long anon_huge_kb() {
+    FILE* f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f) return -1;
+    char line[256];
+    long kb = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) break;
+    }
+    fclose(f);
+    return kb;
+}
+
+int main() {
+    FILE* csv_file = fopen(CSV_FILE, "w");
+    if (!csv_file) {
+        printf("Failed to open CSV file\n");
+        return 1;
+    }
+    fprintf(csv_file, "mode,flags,ns_per_step,dtlb_misses_per_step,anon_huge_kb\n");
+
+    Node** nodes = malloc(NUM_NODES * sizeof(Node*));
+    if (!nodes) {
+        printf("Failed to allocate node index\n");
+        return 1;
+    }
+
+    int dtlb_fd = open_counter(PERF_TYPE_HW_CACHE,
+                               PERF_COUNT_HW_CACHE_DTLB |
+                               (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    if (dtlb_fd < 0) {
+        printf("Compteur dTLB indisponible (perf_event_open), seul le temps est mesuré\n");
+    }
+
+    for (size_t mode = 0; mode < NUM_MODES; mode++) {
+        MemoryAllocator allocator;
+        if (valloc_init_flags(&allocator, INITIAL_BLOCKS, 1, mode_flags[mode]) != 0) {
+            printf("Failed to initialize allocator\n");
+            return 1;
+        }
+
+        for (size_t i = 0; i < NUM_NODES; i++) {
+            nodes[i] = valloc_block(&allocator, sizeof(Node));
+            if (!nodes[i]) {
+                printf("Allocation failed\n");
+                return 1;
+            }
+        }
+
+        // Cycle aléatoire unique (Sattolo) : chaque saut change de page
+        srand(42);
+        for (size_t i = NUM_NODES - 1; i > 0; i--) {
+            size_t j = (size_t)rand() % i;
+            Node* tmp = nodes[i];
+            nodes[i] = nodes[j];
+            nodes[j] = tmp;
+        }
+        for (size_t i = 0; i < NUM_NODES; i++) {
+            nodes[i]->next = nodes[(i + 1) % NUM_NODES];
+        }
+
+        Node* volatile cursor = nodes[0];
+        Node* node = cursor;
+        if (dtlb_fd >= 0) {
+            ioctl(dtlb_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(dtlb_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        double start_time = get_time();
+        for (long step = 0; step < NUM_STEPS; step++) {
+            node = node->next;
+        }
+        double elapsed = get_time() - start_time;
+        if (dtlb_fd >= 0) ioctl(dtlb_fd, PERF_EVENT_IOC_DISABLE, 0);
+        cursor = node;
+
+        long long misses = read_counter(dtlb_fd);
+        double misses_per_step = misses < 0 ? -1.0 : (double)misses / NUM_STEPS;
+        long huge_kb = anon_huge_kb();
+
+        printf("%-8s : %.2f ns par saut, %.3f défauts dTLB par saut, %ld Ko en grandes pages%s\n",
+               mode_names[mode], elapsed / NUM_STEPS, misses_per_step, huge_kb,
+               allocator.flags != mode_flags[mode] ? " (repli sur les grandes pages transparentes)" : "");
+        fprintf(csv_file, "%s,%u,%.3f,%.4f,%ld\n", mode_names[mode], allocator.flags,
+                elapsed / NUM_STEPS, misses_per_step, huge_kb);
+
+        valloc_destroy(&allocator);
+    }
+
+    if (dtlb_fd >= 0) close(dtlb_fd);
+    free(nodes);
+    fclose(csv_file);
+
+    printf("Benchmark completed. Results written to %s\n", CSV_FILE);
+    return 0;
+}
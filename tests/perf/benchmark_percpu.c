@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../src/valloc.h"
+
+#define TOTAL_OPS 4000000
+#define BATCH 64
+#define MAX_OBJECT_SIZE 512
+#define INITIAL_BLOCKS 1000
+#define THREAD_STACK_SIZE (64 * 1024)
+#define CSV_FILE "benchmark_percpu.csv"
+
+// Modes mesurés : caches thread-locaux, caches par processeur (rseq)
+enum { MODE_THREAD, MODE_PERCPU, NUM_MODES };
+static const char* mode_names[NUM_MODES] = {"thread", "percpu"};
+
+// Nombres de threads comparés : autant que de processeurs environ, puis beaucoup plus
+static const int thread_counts[] = {8, 512};
+#define NUM_COUNTS (int)(sizeof(thread_counts) / sizeof(thread_counts[0]))
+
+typedef struct {
+    MemoryAllocator* allocator;
+    unsigned int seed;
+    int ops;
+    int success;
+} ThreadData;
+
+static pthread_barrier_t start_barrier;
+static pthread_barrier_t done_barrier;
+static pthread_barrier_t exit_barrier;
+
+// Temps réel en nanosecondes
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Mémoire résidente du processus, en Mo
+double resident_mb() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+    long size = 0, resident = 0;
+    if (fscanf(f, "%ld %ld", &size, &resident) != 2) resident = -1;
+    fclose(f);
+    return resident < 0 ? -1 : (double)resident * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+// Lots de petits objets ; le thread reste ensuite vivant, caches pleins,
+// le temps que la mémoire soit mesurée
+void* benchmark_thread(void* arg) {
+    ThreadData* data = (ThreadData*)arg;
+    void* ptrs[BATCH];
+
+    pthread_barrier_wait(&start_barrier);
+    for (int done = 0; done < data->ops; done += BATCH) {
+        for (int i = 0; i < BATCH; i++) {
+            size_t size = 16 + (size_t)rand_r(&data->seed) % MAX_OBJECT_SIZE;
+            ptrs[i] = valloc_block(data->allocator, size);
+            if (!ptrs[i]) goto out;
+            *(char*)ptrs[i] = (char)i;
+        }
+        for (int i = 0; i < BATCH; i++) {
+            free_valloc(data->allocator, ptrs[(i * 37) % BATCH]);
+        }
+    }
+    data->success = 1;
+out:
+    pthread_barrier_wait(&done_barrier);
+    pthread_barrier_wait(&exit_barrier);
+    return NULL;
+}
+
+int main() {
+    FILE* csv_file = fopen(CSV_FILE, "w");
+    if (!csv_file) {
+        printf("Failed to open CSV file\n");
+        return 1;
+    }
+    fprintf(csv_file, "mode,threads,mops_per_sec,bytes_mapped_kb,cache_metadata_kb,rss_mb,cache_hit_rate\n");
+    printf("%ld processeurs en ligne\n", sysconf(_SC_NPROCESSORS_ONLN));
+
+    int max_threads = thread_counts[NUM_COUNTS - 1];
+    pthread_t* threads = malloc((size_t)max_threads * sizeof(pthread_t));
+    ThreadData* data = malloc((size_t)max_threads * sizeof(ThreadData));
+    if (!threads || !data) {
+        printf("Failed to allocate thread data\n");
+        return 1;
+    }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+        for (int t = 0; t < NUM_COUNTS; t++) {
+            int num_threads = thread_counts[t];
+            MemoryAllocator allocator;
+            if (valloc_init_flags(&allocator, INITIAL_BLOCKS, num_threads,
+                                  mode == MODE_PERCPU ? VALLOC_PERCPU : 0) != 0) {
+                printf("Failed to initialize allocator\n");
+                return 1;
+            }
+            if (mode == MODE_PERCPU && !(allocator.flags & VALLOC_PERCPU)) {
+                printf("percpu : rseq indisponible, mode ignoré\n");
+                valloc_destroy(&allocator);
+                break;
+            }
+
+            double rss_before = resident_mb();
+            pthread_barrier_init(&start_barrier, NULL, (unsigned int)num_threads + 1);
+            pthread_barrier_init(&done_barrier, NULL, (unsigned int)num_threads + 1);
+            pthread_barrier_init(&exit_barrier, NULL, (unsigned int)num_threads + 1);
+            for (int i = 0; i < num_threads; i++) {
+                data[i].allocator = &allocator;
+                data[i].seed = 42 + (unsigned int)i;
+                data[i].ops = TOTAL_OPS / num_threads;
+                data[i].success = 0;
+                if (pthread_create(&threads[i], &attr, benchmark_thread, &data[i]) != 0) {
+                    printf("Failed to create thread %d\n", i);
+                    return 1;
+                }
+            }
+
+            pthread_barrier_wait(&start_barrier);
+            double start_time = get_time();
+            pthread_barrier_wait(&done_barrier);
+            double elapsed = get_time() - start_time;
+
+            // Tous les threads sont vivants, leurs caches remplis
+            VallocStats stats;
+            valloc_stats(&allocator, &stats);
+            double rss = resident_mb() - rss_before;
+            size_t metadata = mode == MODE_PERCPU ? (size_t)allocator.num_cpus * sizeof(CpuCache)
+                                                  : (size_t)stats.num_threads * sizeof(ThreadCache);
+
+            pthread_barrier_wait(&exit_barrier);
+            for (int i = 0; i < num_threads; i++) {
+                pthread_join(threads[i], NULL);
+                if (!data[i].success) {
+                    printf("Allocation failed\n");
+                    return 1;
+                }
+            }
+            pthread_barrier_destroy(&start_barrier);
+            pthread_barrier_destroy(&done_barrier);
+            pthread_barrier_destroy(&exit_barrier);
+            valloc_destroy(&allocator);
+
+            // Une opération : une allocation et sa libération
+            double mops = (double)(TOTAL_OPS / num_threads * num_threads) / elapsed * 1e3;
+            uint64_t lookups = stats.cache_hits + stats.cache_misses;
+            double hit_rate = lookups ? 100.0 * stats.cache_hits / lookups : 0.0;
+            printf("%-6s %3d threads : %6.2f Mop/s, %6zu Ko projetés, %6zu Ko de caches, %6.1f Mo résidents, "
+                   "%.1f %% de succès\n",
+                   mode_names[mode], num_threads, mops, stats.bytes_mapped / 1024, metadata / 1024, rss, hit_rate);
+            fprintf(csv_file, "%s,%d,%.3f,%zu,%zu,%.1f,%.1f\n", mode_names[mode], num_threads, mops,
+                    stats.bytes_mapped / 1024, metadata / 1024, rss, hit_rate);
+        }
+    }
+
+    pthread_attr_destroy(&attr);
+    free(threads);
+    free(data);
+    fclose(csv_file);
+    printf("Benchmark completed. Results written to %s\n", CSV_FILE);
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../src/valloc.h"
+
+#define NUM_PAIRS 2
+#define NUM_ITEMS 2000000
+#define RING_SIZE 1024
+#define SAMPLE_EVERY 100000
+#define INITIAL_BLOCKS 10000
+#define CSV_FILE "benchmark_producer_consumer.csv"
+
+// File SPSC entre un producteur et un consommateur
+typedef struct {
+    void* items[RING_SIZE];
+    size_t head;    // Écrit par le consommateur
+    size_t tail;    // Écrit par le producteur
+} Ring;
+
+typedef struct {
+    Ring ring;
+    int use_valloc;
+    int pair_id;
+} Pair;
+
+MemoryAllocator allocator;
+FILE* csv_file = NULL;
+double start_time;
+
+// Fonction pour mesurer le temps en secondes
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Mémoire résidente du processus en Ko
+long get_rss_kb() {
+    long pages = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+    if (fscanf(f, "%*s %ld", &pages) != 1) pages = -1;
+    fclose(f);
+    return pages < 0 ? -1 : pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+void* producer(void* arg) {
+    Pair* pair = (Pair*)arg;
+    Ring* ring = &pair->ring;
+
+    for (size_t i = 0; i < NUM_ITEMS; i++) {
+        // Tailles variées de petits messages
+        size_t size = 16 + (i % 32) * 16;
+        void* ptr = pair->use_valloc ? valloc_block(&allocator, size) : malloc(size);
+        if (!ptr) {
+            fprintf(stderr, "Échec de l'allocation\n");
+            exit(1);
+        }
+        *(size_t*)ptr = i;
+
+        while (i - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) >= RING_SIZE) {
+            sched_yield();
+        }
+        ring->items[i % RING_SIZE] = ptr;
+        __atomic_store_n(&ring->tail, i + 1, __ATOMIC_RELEASE);
+
+        // Dérive de la mémoire résidente au fil du temps
+        if (pair->pair_id == 0 && (i + 1) % SAMPLE_EVERY == 0) {
+            fprintf(csv_file, "%s,%.6f,%zu,%ld\n", pair->use_valloc ? "valloc" : "malloc",
+                    get_time() - start_time, (i + 1) * NUM_PAIRS, get_rss_kb());
+        }
+    }
+    return NULL;
+}
+
+void* consumer(void* arg) {
+    Pair* pair = (Pair*)arg;
+    Ring* ring = &pair->ring;
+
+    for (size_t i = 0; i < NUM_ITEMS; i++) {
+        while (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) <= i) {
+            sched_yield();
+        }
+        void* ptr = ring->items[i % RING_SIZE];
+        __atomic_store_n(&ring->head, i + 1, __ATOMIC_RELEASE);
+
+        if (*(size_t*)ptr != i) {
+            fprintf(stderr, "Message corrompu\n");
+            exit(1);
+        }
+        if (pair->use_valloc) {
+            free_valloc(&allocator, ptr);
+        } else {
+            free(ptr);
+        }
+    }
+    return NULL;
+}
+
+int main() {
+    csv_file = fopen(CSV_FILE, "w");
+    if (!csv_file) {
+        printf("Failed to open CSV file\n");
+        return 1;
+    }
+    fprintf(csv_file, "allocator,elapsed,items,rss_kb\n");
+
+    if (valloc_init(&allocator, INITIAL_BLOCKS, MAX_THREADS) != 0) {
+        printf("Failed to initialize allocator\n");
+        return 1;
+    }
+
+    for (int use_valloc = 1; use_valloc >= 0; use_valloc--) {
+        pthread_t producers[NUM_PAIRS], consumers[NUM_PAIRS];
+        Pair* pairs = calloc(NUM_PAIRS, sizeof(Pair));
+        if (!pairs) return 1;
+
+        start_time = get_time();
+        for (int i = 0; i < NUM_PAIRS; i++) {
+            pairs[i].use_valloc = use_valloc;
+            pairs[i].pair_id = i;
+            if (pthread_create(&producers[i], NULL, producer, &pairs[i]) != 0 ||
+                pthread_create(&consumers[i], NULL, consumer, &pairs[i]) != 0) {
+                printf("Failed to create thread %d\n", i);
+                return 1;
+            }
+        }
+        for (int i = 0; i < NUM_PAIRS; i++) {
+            pthread_join(producers[i], NULL);
+            pthread_join(consumers[i], NULL);
+        }
+        double elapsed = get_time() - start_time;
+
+        printf("%-6s : %.0f messages/s, RSS final %ld Ko\n", use_valloc ? "valloc" : "malloc",
+               NUM_ITEMS * NUM_PAIRS / elapsed, get_rss_kb());
+        free(pairs);
+    }
+
+    valloc_destroy(&allocator);
+    fclose(csv_file);
+
+    printf("Benchmark completed. Results written to %s\n", CSV_FILE);
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../../src/valloc.h"
+
+#define MIN_SIZE ((size_t)16)
+#define MAX_SIZE ((size_t)256 * 1024 * 1024)
+#define NUM_ROUNDS 5
+#define INITIAL_BLOCKS 1000
+#define CSV_FILE "benchmark_realloc.csv"
+
+// Modes mesurés pour un tampon doublé de MIN_SIZE à MAX_SIZE
+enum { MODE_VALLOC_REALLOC, MODE_VALLOC_COPY, MODE_GLIBC, NUM_MODES };
+static const char* mode_names[NUM_MODES] = {"valloc_realloc", "valloc_copy", "glibc"};
+
+MemoryAllocator allocator;
+
+// Temps CPU du thread en nanosecondes (appels système compris)
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Redimensionne le tampon selon le mode mesuré
+void* grow(int mode, void* ptr, size_t old_size, size_t size) {
+    switch (mode) {
+    case MODE_VALLOC_REALLOC:
+        return valloc_realloc(&allocator, ptr, size);
+    case MODE_VALLOC_COPY: {
+        // Ancien motif : nouvelle allocation, copie puis libération
+        void* new_ptr = valloc_block(&allocator, size);
+        if (new_ptr && ptr) {
+            memcpy(new_ptr, ptr, old_size);
+            free_valloc(&allocator, ptr);
+        }
+        return new_ptr;
+    }
+    default:
+        return realloc(ptr, size);
+    }
+}
+
+void release(int mode, void* ptr) {
+    if (mode == MODE_GLIBC) {
+        free(ptr);
+    } else {
+        free_valloc(&allocator, ptr);
+    }
+}
+
+int main() {
+    FILE* csv_file = fopen(CSV_FILE, "w");
+    if (!csv_file) {
+        printf("Failed to open CSV file\n");
+        return 1;
+    }
+    fprintf(csv_file, "mode,round,size,ns,moved\n");
+
+    if (valloc_init(&allocator, INITIAL_BLOCKS, 1) != 0) {
+        printf("Failed to initialize allocator\n");
+        return 1;
+    }
+
+    // Doublements successifs ; un octet écrit au début et à la fin de chaque
+    // nouvelle moitié vérifie que le contenu suit le tampon
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+        double total = 0;
+        int moves = 0;
+        for (int round = 0; round < NUM_ROUNDS; round++) {
+            unsigned char* buffer = NULL;
+            size_t old_size = 0;
+            for (size_t size = MIN_SIZE; size <= MAX_SIZE; size *= 2) {
+                double start_time = get_time();
+                unsigned char* new_buffer = grow(mode, buffer, old_size, size);
+                double elapsed = get_time() - start_time;
+                if (new_buffer == NULL) {
+                    printf("Allocation failed at %zu bytes\n", size);
+                    return 1;
+                }
+                if (old_size && (new_buffer[0] != 0xA5 || new_buffer[old_size - 1] != 0x5A)) {
+                    printf("Content lost at %zu bytes (%s)\n", size, mode_names[mode]);
+                    return 1;
+                }
+                int moved = buffer != NULL && new_buffer != buffer;
+                moves += moved;
+                buffer = new_buffer;
+                buffer[old_size] = 0xA5;
+                buffer[size - 1] = 0x5A;
+                old_size = size;
+
+                total += elapsed;
+                fprintf(csv_file, "%s,%d,%zu,%.0f,%d\n", mode_names[mode], round, size, elapsed, moved);
+            }
+            release(mode, buffer);
+        }
+        printf("%-15s : %.3f ms par série de doublements (%d déplacements par série)\n",
+               mode_names[mode], total / NUM_ROUNDS / 1e6, moves / NUM_ROUNDS);
+    }
+
+    valloc_destroy(&allocator);
+    fclose(csv_file);
+
+    printf("Benchmark completed. Results written to %s\n", CSV_FILE);
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../../src/valloc.h"
+#include "../../valloc.h"
+
+#define TOTAL_OPS 2000000
+#define LIVE_BLOCKS 1024
+#define MIXED_MAX_SIZE 2048
+#define INITIAL_BLOCKS 1000
+#define CSV_FILE "benchmark_root_vs_valloc.csv"
+
+// Allocateurs comparés : celui de la racine (valloc.c) et celui de src/
+enum { ALLOC_ROOT, ALLOC_SRC, NUM_ALLOCATORS };
+static const char* allocator_names[NUM_ALLOCATORS] = {"root", "src"};
+
+// Tailles fixes mesurées, toutes dans les petites classes des deux allocateurs ;
+// 0 désigne la charge mixte (tailles aléatoires jusqu'à MIXED_MAX_SIZE)
+static const size_t workload_sizes[] = {16, 64, 256, 1024, 2048, 0};
+#define NUM_WORKLOADS (int)(sizeof(workload_sizes) / sizeof(workload_sizes[0]))
+
+// Temps réel en nanosecondes
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Les deux allocateurs derrière la même interface
+typedef struct {
+    int kind;
+    memory_manager_t root;
+    MemoryAllocator src;
+} BenchAllocator;
+
+static int bench_init(BenchAllocator* a, int kind) {
+    a->kind = kind;
+    if (kind == ALLOC_ROOT) return init_vallocator(&a->root);
+    return valloc_init(&a->src, INITIAL_BLOCKS, 1);
+}
+
+static void* bench_alloc(BenchAllocator* a, size_t size) {
+    if (a->kind == ALLOC_ROOT) return valloc_alloc(&a->root, size);
+    return valloc_block(&a->src, size);
+}
+
+static void bench_free(BenchAllocator* a, void* ptr) {
+    if (a->kind == ALLOC_ROOT) vafree(&a->root, ptr);
+    else free_valloc(&a->src, ptr);
+}
+
+static void bench_destroy(BenchAllocator* a) {
+    if (a->kind == ALLOC_ROOT) cleanup_vallocator(&a->root);
+    else valloc_destroy(&a->src);
+}
+
+// Remplace aléatoirement l'un des LIVE_BLOCKS blocs vivants à chaque opération ;
+// la graine est fixe pour que les deux allocateurs voient la même suite de tailles
+static int run_workload(BenchAllocator* a, size_t size) {
+    void* live[LIVE_BLOCKS] = {0};
+    unsigned int seed = 42;
+    for (int op = 0; op < TOTAL_OPS; op++) {
+        int slot = rand_r(&seed) % LIVE_BLOCKS;
+        size_t request = size ? size : (size_t)(rand_r(&seed) % MIXED_MAX_SIZE) + 1;
+        if (live[slot]) bench_free(a, live[slot]);
+        live[slot] = bench_alloc(a, request);
+        if (!live[slot]) return -1;
+        *(char*)live[slot] = (char)op;
+    }
+    for (int i = 0; i < LIVE_BLOCKS; i++) {
+        if (live[i]) bench_free(a, live[i]);
+    }
+    return 0;
+}
+
+// Débit en millions d'opérations (allocation et libération) par seconde
+double measure(int kind, size_t size) {
+    BenchAllocator allocator;
+    if (bench_init(&allocator, kind) != 0) return -1;
+    double start_time = get_time();
+    int result = run_workload(&allocator, size);
+    double elapsed = get_time() - start_time;
+    bench_destroy(&allocator);
+    if (result != 0) return -1;
+    return (double)TOTAL_OPS / elapsed * 1e3;
+}
+
+int main() {
+    FILE* csv_file = fopen(CSV_FILE, "w");
+    if (!csv_file) {
+        printf("Failed to open CSV file\n");
+        return 1;
+    }
+    fprintf(csv_file, "workload,root_mops_per_sec,src_mops_per_sec,speedup\n");
+
+    for (int w = 0; w < NUM_WORKLOADS; w++) {
+        size_t size = workload_sizes[w];
+        double results[NUM_ALLOCATORS];
+        for (int kind = 0; kind < NUM_ALLOCATORS; kind++) {
+            results[kind] = measure(kind, size);
+            if (results[kind] < 0) {
+                printf("Allocation failed (%s)\n", allocator_names[kind]);
+                return 1;
+            }
+        }
+        char workload[32];
+        if (size) snprintf(workload, sizeof(workload), "%zu", size);
+        else snprintf(workload, sizeof(workload), "mixed");
+        printf("%-6s : %6.2f Mop/s racine, %6.2f Mop/s src (x%.2f)\n", workload,
+               results[ALLOC_ROOT], results[ALLOC_SRC], results[ALLOC_SRC] / results[ALLOC_ROOT]);
+        fprintf(csv_file, "%s,%.3f,%.3f,%.3f\n", workload, results[ALLOC_ROOT], results[ALLOC_SRC],
+                results[ALLOC_SRC] / results[ALLOC_ROOT]);
+    }
+
+    fclose(csv_file);
+    printf("Benchmark completed. Results written to %s\n", CSV_FILE);
+    return 0;
+}
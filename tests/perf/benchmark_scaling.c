@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../src/valloc.h"
+
+#define MAX_BENCH_THREADS 64
+#define OPS_PER_THREAD 200000
+#define BATCH 256
+#define MAX_OBJECT_SIZE 1024
+#define INITIAL_BLOCKS 1000
+#define CSV_FILE "benchmark_scaling.csv"
+
+// Modes mesurés : caches thread-locaux, listes centrales seules (sans cache), malloc de la glibc
+enum { MODE_CACHE, MODE_CENTRAL, MODE_MALLOC, NUM_MODES };
+static const char* mode_names[NUM_MODES] = {"cache", "central", "malloc"};
+
+typedef struct {
+    MemoryAllocator* allocator;    // NULL : malloc de la glibc
+    unsigned int seed;
+    int success;
+} ThreadData;
+
+static pthread_barrier_t start_barrier;
+
+// Temps réel en nanosecondes : le débit total dépend du parallélisme,
+// le temps CPU d'un thread ne suffit pas
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Lots d'allocations de tailles aléatoires, libérées dans le désordre :
+// les caches débordent et se remplissent, le chemin lent est sollicité
+void* benchmark_thread(void* arg) {
+    ThreadData* data = (ThreadData*)arg;
+    void* ptrs[BATCH];
+
+    pthread_barrier_wait(&start_barrier);
+    for (int done = 0; done < OPS_PER_THREAD; done += BATCH) {
+        for (int i = 0; i < BATCH; i++) {
+            size_t size = 16 + (size_t)rand_r(&data->seed) % MAX_OBJECT_SIZE;
+            ptrs[i] = data->allocator ? valloc_block(data->allocator, size) : malloc(size);
+            if (!ptrs[i]) return NULL;
+            *(char*)ptrs[i] = (char)i;
+        }
+        for (int i = 0; i < BATCH; i++) {
+            int j = (i * 97) % BATCH;
+            if (data->allocator) {
+                free_valloc(data->allocator, ptrs[j]);
+            } else {
+                free(ptrs[j]);
+            }
+        }
+    }
+    data->success = 1;
+    return NULL;
+}
+
+int main() {
+    FILE* csv_file = fopen(CSV_FILE, "w");
+    if (!csv_file) {
+        printf("Failed to open CSV file\n");
+        return 1;
+    }
+    fprintf(csv_file, "mode,threads,mops_per_sec,speedup,class_contention,arena_contention,global_contention\n");
+    printf("%ld processeurs en ligne\n", sysconf(_SC_NPROCESSORS_ONLN));
+
+    pthread_t threads[MAX_BENCH_THREADS];
+    ThreadData data[MAX_BENCH_THREADS];
+
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+        double base = 0;
+        for (int num_threads = 1; num_threads <= MAX_BENCH_THREADS; num_threads *= 2) {
+            MemoryAllocator allocator;
+            if (mode != MODE_MALLOC &&
+                valloc_init(&allocator, INITIAL_BLOCKS, mode == MODE_CACHE ? num_threads : 0) != 0) {
+                printf("Failed to initialize allocator\n");
+                return 1;
+            }
+
+            pthread_barrier_init(&start_barrier, NULL, (unsigned int)num_threads + 1);
+            for (int i = 0; i < num_threads; i++) {
+                data[i].allocator = mode == MODE_MALLOC ? NULL : &allocator;
+                data[i].seed = 42 + (unsigned int)i;
+                data[i].success = 0;
+                if (pthread_create(&threads[i], NULL, benchmark_thread, &data[i]) != 0) {
+                    printf("Failed to create thread %d\n", i);
+                    return 1;
+                }
+            }
+
+            pthread_barrier_wait(&start_barrier);
+            double start_time = get_time();
+            for (int i = 0; i < num_threads; i++) {
+                pthread_join(threads[i], NULL);
+                if (!data[i].success) {
+                    printf("Allocation failed\n");
+                    return 1;
+                }
+            }
+            double elapsed = get_time() - start_time;
+            pthread_barrier_destroy(&start_barrier);
+
+            // Une opération : une allocation et sa libération
+            double mops = (double)num_threads * OPS_PER_THREAD / elapsed * 1e3;
+            if (num_threads == 1) base = mops;
+
+            VallocStats stats;
+            memset(&stats, 0, sizeof(stats));
+            if (mode != MODE_MALLOC) {
+                valloc_stats(&allocator, &stats);
+                valloc_destroy(&allocator);
+            }
+
+            printf("%-7s %2d threads : %7.2f Mop/s (x%.2f), attentes : %llu classe, %llu arène, %llu global\n",
+                   mode_names[mode], num_threads, mops, mops / base,
+                   (unsigned long long)stats.class_contention, (unsigned long long)stats.arena_contention,
+                   (unsigned long long)stats.global_contention);
+            fprintf(csv_file, "%s,%d,%.3f,%.3f,%llu,%llu,%llu\n", mode_names[mode], num_threads, mops, mops / base,
+                    (unsigned long long)stats.class_contention, (unsigned long long)stats.arena_contention,
+                    (unsigned long long)stats.global_contention);
+        }
+    }
+
+    fclose(csv_file);
+    printf("Benchmark completed. Results written to %s\n", CSV_FILE);
+    return 0;
+}
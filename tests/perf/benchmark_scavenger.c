@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../../src/valloc.h"
+
+#define NUM_BURSTS 5
+#define BLOCKS_PER_BURST 256
+#define SMALL_PER_BURST 20000
+#define MIN_BLOCK_SIZE (64 * 1024)
+#define MAX_BLOCK_SIZE (1024 * 1024)
+#define IDLE_MS 200
+#define SCAVENGE_INTERVAL_MS 50
+#define INITIAL_BLOCKS 1000
+#define CSV_FILE "benchmark_scavenger.csv"
+
+// Modes mesurés : sans purge, purge immédiate, purge paresseuse
+enum { MODE_NONE, MODE_DONTNEED, MODE_FREE, NUM_MODES };
+static const char* mode_names[NUM_MODES] = {"none", "dontneed", "free"};
+
+// Temps CPU du thread en nanosecondes
+double get_time() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Mémoire résidente du processus, en Mo
+double resident_mb() {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return -1;
+    long size = 0, resident = 0;
+    if (fscanf(f, "%ld %ld", &size, &resident) != 2) resident = -1;
+    fclose(f);
+    return resident < 0 ? -1 : (double)resident * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+// Pause en temps réel : le thread de purge travaille pendant ce temps
+void idle(long ms) {
+    struct timespec ts = {ms / 1000, (ms % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+int main() {
+    FILE* csv_file = fopen(CSV_FILE, "w");
+    if (!csv_file) {
+        printf("Failed to open CSV file\n");
+        return 1;
+    }
+    fprintf(csv_file, "mode,burst,burst_ns,rss_peak_mb,rss_idle_mb\n");
+
+    void** blocks = malloc(BLOCKS_PER_BURST * sizeof(void*));
+    void** small = malloc(SMALL_PER_BURST * sizeof(void*));
+    if (!blocks || !small) {
+        printf("Failed to allocate block index\n");
+        return 1;
+    }
+
+    for (int mode = 0; mode < NUM_MODES; mode++) {
+        MemoryAllocator allocator;
+        if (valloc_init(&allocator, INITIAL_BLOCKS, 1) != 0) {
+            printf("Failed to initialize allocator\n");
+            return 1;
+        }
+        if (mode != MODE_NONE &&
+            valloc_scavenger_start(&allocator, SCAVENGE_INTERVAL_MS,
+                                   mode == MODE_FREE ? VALLOC_PURGE_FREE : VALLOC_PURGE_DONTNEED) != 0) {
+            printf("Failed to start scavenger\n");
+            return 1;
+        }
+
+        double total_burst = 0, total_idle_rss = 0;
+        srand(42);
+        for (int burst = 0; burst < NUM_BURSTS; burst++) {
+            // Pic de charge : grands blocs et petits objets, tous écrits
+            double start_time = get_time();
+            for (int i = 0; i < BLOCKS_PER_BURST; i++) {
+                size_t size = MIN_BLOCK_SIZE + (size_t)rand() % (MAX_BLOCK_SIZE - MIN_BLOCK_SIZE);
+                blocks[i] = valloc_block(&allocator, size);
+                if (!blocks[i]) {
+                    printf("Allocation failed\n");
+                    return 1;
+                }
+                memset(blocks[i], burst, size);
+            }
+            for (int i = 0; i < SMALL_PER_BURST; i++) {
+                small[i] = valloc_block(&allocator, 16 + (size_t)rand() % 512);
+                if (!small[i]) {
+                    printf("Allocation failed\n");
+                    return 1;
+                }
+                memset(small[i], burst, 16);
+            }
+            double rss_peak = resident_mb();
+
+            for (int i = 0; i < BLOCKS_PER_BURST; i++) {
+                revalloc(&allocator, blocks[i]);
+            }
+            for (int i = 0; i < SMALL_PER_BURST; i++) {
+                free_valloc(&allocator, small[i]);
+            }
+            double elapsed = get_time() - start_time;
+
+            // Creux de charge
+            idle(IDLE_MS);
+            double rss_idle = resident_mb();
+
+            total_burst += elapsed;
+            total_idle_rss += rss_idle;
+            fprintf(csv_file, "%s,%d,%.0f,%.1f,%.1f\n", mode_names[mode], burst, elapsed, rss_peak, rss_idle);
+        }
+
+        printf("%-9s : %.2f ms par pic, %.1f Mo résidents entre les pics, %zu Mo purgés\n",
+               mode_names[mode], total_burst / NUM_BURSTS / 1e6, total_idle_rss / NUM_BURSTS,
+               allocator.scavenger.purged_bytes / (1024 * 1024));
+        valloc_destroy(&allocator);
+    }
+
+    free(blocks);
+    free(small);
+    fclose(csv_file);
+
+    printf("Benchmark completed. Results written to %s\n", CSV_FILE);
+    return 0;
+}
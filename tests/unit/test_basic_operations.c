@@ -1,6 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
 #include "valloc.h"
 
 // Test d'initialisation et de destruction
@@ -64,12 +68,451 @@ void test_block_recycling() {
     printf("✓ Test de recyclage des blocs réussi\n");
 }
 
+// Test du choix du bloc recyclé le mieux adapté
+void test_recycling_best_fit() {
+    MemoryAllocator allocator;
+    valloc_init(&allocator, 100, 4);
+
+    // Tailles au-delà des slabs : blocs mmap dédiés recyclés par classe
+    void* large = valloc_block(&allocator, 1048576);
+    void* medium = valloc_block(&allocator, 65536);
+    void* small = valloc_block(&allocator, 16384);
+    assert(large != NULL && medium != NULL && small != NULL);
+
+    revalloc(&allocator, large);
+    revalloc(&allocator, medium);
+    revalloc(&allocator, small);
+
+    // Une petite demande ne doit pas consommer le grand bloc
+    assert(valloc_block(&allocator, 16384) == small);
+    assert(valloc_block(&allocator, 40000) == medium);
+    assert(valloc_block(&allocator, 100000) == large);
+
+    valloc_destroy(&allocator);
+    printf("✓ Test de best-fit des blocs recyclés réussi\n");
+}
+
+// Test du cache des grandes projections : réutilisation, découpe, mremap et borne
+void test_large_cache() {
+    MemoryAllocator allocator;
+    valloc_init(&allocator, 100, 4);
+    const size_t mb = 1024 * 1024;
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    VallocStats stats;
+
+    // Un bloc libéré reste projeté
+    char* big = valloc_block(&allocator, 16 * mb);
+    assert(big != NULL);
+    free_valloc(&allocator, big);
+    assert(valloc_stats(&allocator, &stats) == 0);
+    assert(stats.bytes_recycled == 16 * mb);
+    uint64_t mmaps = stats.mmap_calls;
+
+    // Demande plus petite : même projection, fin rendue au système, taille arrondie à la page
+    char* ptr = valloc_block(&allocator, 4 * mb + 1);
+    assert(ptr == big);
+    assert(valloc_usable_size(&allocator, ptr) == 4 * mb + page);
+    assert(valloc_stats(&allocator, &stats) == 0);
+    assert(stats.mmap_calls == mmaps && stats.large_reuses == 1 && stats.bytes_recycled == 0);
+    memset(ptr, 0x5a, 4 * mb);
+    free_valloc(&allocator, ptr);
+
+    // Demande plus grande : la projection recyclée est agrandie par mremap, contenu conservé
+    uint64_t mremaps = stats.mremap_calls;
+    ptr = valloc_block(&allocator, 6 * mb);
+    assert(ptr != NULL && (unsigned char)ptr[4 * mb - 1] == 0x5a);
+    assert(valloc_usable_size(&allocator, ptr) == 6 * mb);
+    assert(valloc_stats(&allocator, &stats) == 0);
+    assert(stats.mmap_calls == mmaps && stats.mremap_calls == mremaps + 1 && stats.large_reuses == 2);
+    memset(ptr, 0, 6 * mb);
+
+    // Borne : au-delà de 8 Mo recyclés, le bloc libéré est rendu au système
+    assert(valloc_set_large_cache(&allocator, 8 * mb) == 0);
+    char* other = valloc_block(&allocator, 4 * mb);
+    free_valloc(&allocator, ptr);
+    assert(valloc_stats(&allocator, &stats) == 0);
+    uint64_t munmaps = stats.munmap_calls;
+    free_valloc(&allocator, other);
+    assert(valloc_stats(&allocator, &stats) == 0);
+    assert(stats.bytes_recycled == 6 * mb && stats.munmap_calls == munmaps + 1);
+
+    // revalloc respecte la même borne
+    char* recycled[4];
+    for (int i = 0; i < 4; i++) recycled[i] = valloc_block(&allocator, 4 * mb);
+    for (int i = 0; i < 4; i++) revalloc(&allocator, recycled[i]);
+    assert(valloc_stats(&allocator, &stats) == 0);
+    assert(stats.bytes_recycled <= 8 * mb);
+
+    valloc_destroy(&allocator);
+    printf("✓ Test du cache des grandes projections réussi\n");
+}
+
+// Test des petits objets regroupés dans les slabs
+void test_slab_packing() {
+    MemoryAllocator allocator;
+    valloc_init(&allocator, 10, 4);
+
+    // Bien plus d'objets que d'emplacements dans la table : un chunk suffit
+    void* ptrs[1000];
+    for (int i = 0; i < 1000; i++) {
+        ptrs[i] = valloc_block(&allocator, 24);
+        assert(ptrs[i] != NULL);
+        assert(((size_t)ptrs[i] & 15) == 0);
+        memset(ptrs[i], i & 0xff, 24);
+    }
+    assert(allocator.used_blocks == 1);
+
+    // Objets contigus, sans recouvrement
+    for (int i = 0; i < 1000; i++) {
+        unsigned char* p = ptrs[i];
+        for (int j = 0; j < 24; j++) {
+            assert(p[j] == (unsigned char)(i & 0xff));
+        }
+    }
+
+    // Le chunk est rendu au système une fois vide
+    for (int i = 0; i < 1000; i++) {
+        revalloc(&allocator, ptrs[i]);
+    }
+    valloc_cleanup(&allocator);
+    assert(allocator.used_blocks == 0);
+
+    valloc_destroy(&allocator);
+    printf("✓ Test de regroupement des petits objets réussi\n");
+}
+
+void test_usable_size() {
+    MemoryAllocator allocator;
+    valloc_init(&allocator, 10, 4);
+
+    // Petit objet : taille de sa classe
+    void* small = valloc_block(&allocator, 100);
+    assert(valloc_usable_size(&allocator, small) == 112);
+
+    // Grand bloc : au moins la taille demandée
+    void* large = valloc_block(&allocator, 100000);
+    assert(valloc_usable_size(&allocator, large) >= 100000);
+
+    // Pointeurs inconnus ou intérieurs
+    int local;
+    assert(valloc_usable_size(&allocator, &local) == 0);
+    assert(valloc_usable_size(&allocator, (char*)small + 8) == 0);
+    assert(valloc_usable_size(&allocator, (char*)large + 8) == 0);
+
+    free_valloc(&allocator, small);
+    free_valloc(&allocator, large);
+    valloc_destroy(&allocator);
+    printf("✓ Test de taille utilisable réussi\n");
+}
+
+void test_realloc() {
+    MemoryAllocator allocator;
+    valloc_init(&allocator, 10, 4);
+
+    // NULL : allocation
+    char* ptr = valloc_realloc(&allocator, NULL, 100);
+    assert(ptr != NULL);
+    memset(ptr, 'a', 100);
+
+    // Réduction dans la même classe : en place
+    assert(valloc_realloc(&allocator, ptr, 90) == ptr);
+
+    // Agrandissement vers les grands blocs : contenu préservé
+    ptr = valloc_realloc(&allocator, ptr, 100000);
+    assert(ptr != NULL);
+    for (int i = 0; i < 90; i++) assert(ptr[i] == 'a');
+    memset(ptr, 'b', 100000);
+
+    // Agrandissement par mremap, puis réduction en place
+    ptr = valloc_realloc(&allocator, ptr, 8 * 1024 * 1024);
+    assert(ptr != NULL);
+    for (int i = 0; i < 100000; i++) assert(ptr[i] == 'b');
+    assert(valloc_usable_size(&allocator, ptr) >= 8 * 1024 * 1024);
+    assert(valloc_realloc(&allocator, ptr, 50000) == ptr);
+    assert(valloc_usable_size(&allocator, ptr) < 8 * 1024 * 1024);
+    assert(ptr[49999] == 'b');
+
+    // Retour vers un petit objet
+    ptr = valloc_realloc(&allocator, ptr, 64);
+    assert(ptr != NULL && ptr[63] == 'b');
+
+    // Taille 0 : libération
+    assert(valloc_realloc(&allocator, ptr, 0) == NULL);
+
+    valloc_destroy(&allocator);
+    printf("✓ Test de redimensionnement réussi\n");
+}
+
+void test_aligned() {
+    MemoryAllocator allocator;
+    valloc_init(&allocator, 100, 4);
+
+    // Petits objets alignés : groupés dans un seul chunk
+    void* ptrs[1000];
+    for (int i = 0; i < 1000; i++) {
+        ptrs[i] = valloc_aligned(&allocator, 24, 64);
+        assert(ptrs[i] != NULL);
+        assert(((size_t)ptrs[i] & 63) == 0);
+        memset(ptrs[i], i & 0xff, 24);
+    }
+    assert(allocator.used_blocks == 1);
+    for (int i = 0; i < 1000; i++) {
+        free_valloc(&allocator, ptrs[i]);
+    }
+
+    // Tous les alignements de 16 o à 2 MiB, petites et grandes tailles
+    size_t sizes[] = {1, 100, 3000, 8192, 20000, 3 * 1024 * 1024};
+    for (size_t alignment = 16; alignment <= VALLOC_MAX_ALIGNMENT; alignment *= 2) {
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            char* ptr = valloc_aligned(&allocator, sizes[i], alignment);
+            assert(ptr != NULL);
+            assert(((size_t)ptr & (alignment - 1)) == 0);
+            assert(valloc_usable_size(&allocator, ptr) >= sizes[i]);
+            ptr[0] = 1;
+            ptr[sizes[i] - 1] = 1;
+            free_valloc(&allocator, ptr);
+        }
+    }
+
+    // Alignements invalides
+    assert(valloc_aligned(&allocator, 64, 48) == NULL);
+    assert(valloc_aligned(&allocator, 64, VALLOC_MAX_ALIGNMENT * 2) == NULL);
+
+    valloc_destroy(&allocator);
+    printf("✓ Test d'allocation alignée réussi\n");
+}
+
+void test_table_growth() {
+    MemoryAllocator allocator;
+    valloc_init(&allocator, 10, 4);
+
+    // Bien plus de grands blocs vivants que la capacité initiale
+    void* ptrs[2000];
+    for (int i = 0; i < 2000; i++) {
+        ptrs[i] = valloc_block(&allocator, 16384);
+        assert(ptrs[i] != NULL);
+        *(int*)ptrs[i] = i;
+    }
+    assert(allocator.total_blocks >= 2000);
+
+    // Les blocs restent retrouvables après l'agrandissement de la table
+    for (int i = 0; i < 2000; i++) {
+        assert(*(int*)ptrs[i] == i);
+        assert(valloc_usable_size(&allocator, ptrs[i]) == 16384);
+    }
+    for (int i = 0; i < 2000; i++) {
+        free_valloc(&allocator, ptrs[i]);
+    }
+
+    valloc_destroy(&allocator);
+    printf("✓ Test d'agrandissement de la table réussi\n");
+}
+
+void test_huge_pages() {
+    MemoryAllocator allocator;
+    assert(valloc_init_flags(&allocator, 10, 4, 0x80) == -1);
+    assert(valloc_init_flags(&allocator, 10, 4, VALLOC_HUGETLB) == 0);
+
+    // Petits objets : chunk en grandes pages réservées, ou repli transparent
+    char* small = valloc_block(&allocator, 64);
+    assert(small != NULL);
+    memset(small, 1, 64);
+    assert(allocator.flags == VALLOC_HUGETLB || allocator.flags == VALLOC_HUGE_PAGES);
+
+    // Grand bloc : aligné sur une grande page
+    char* large = valloc_block(&allocator, 4 * 1024 * 1024);
+    assert(large != NULL);
+    assert(((size_t)large & (VALLOC_HUGE_PAGE_SIZE - 1)) == 0);
+    memset(large, 1, 4 * 1024 * 1024);
+
+    free_valloc(&allocator, small);
+    free_valloc(&allocator, large);
+    valloc_destroy(&allocator);
+    printf("✓ Test des grandes pages réussi\n");
+}
+
+// Nombre de pages résidentes d'une plage alignée sur une page
+size_t resident_pages(void* ptr, size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t count = (size + page - 1) / page;
+    unsigned char vec[count];
+    assert(mincore(ptr, size, vec) == 0);
+    size_t resident = 0;
+    for (size_t i = 0; i < count; i++) resident += vec[i] & 1;
+    return resident;
+}
+
+// Test de la purge des blocs recyclés et des spans inutilisées
+void test_scavenger() {
+    MemoryAllocator allocator;
+    assert(valloc_init(&allocator, 100, 0) == 0);
+
+    // Un bloc recyclé n'est purgé qu'après un passage complet
+    const size_t size = 1024 * 1024;
+    char* block = valloc_block(&allocator, size);
+    memset(block, 0xAB, size);
+    revalloc(&allocator, block);
+    assert(valloc_scavenge(&allocator) == 0);
+    assert(resident_pages(block, size) > 0);
+    assert(valloc_scavenge(&allocator) >= size);
+    assert(resident_pages(block, size) == 0);
+    assert(valloc_scavenge(&allocator) == 0);
+
+    // La plage virtuelle est conservée et réutilisée
+    char* again = valloc_block(&allocator, size);
+    assert(again == block);
+    memset(again, 0xCD, size);
+
+    // Spans vidées : rendues à leur chunk, puis purgées
+    const size_t per_span = SLAB_SPAN_SIZE / 64;
+    const size_t count = 4 * per_span;
+    void** objects = malloc(count * sizeof(void*));
+    for (size_t i = 0; i < count; i++) {
+        objects[i] = valloc_block(&allocator, 64);
+        assert(objects[i] != NULL);
+        memset(objects[i], 1, 64);
+    }
+    for (size_t i = 0; i < count - 1; i++) {
+        free_valloc(&allocator, objects[i]);
+    }
+    valloc_scavenge(&allocator);
+    assert(valloc_scavenge(&allocator) >= 2 * SLAB_SPAN_SIZE);
+    free_valloc(&allocator, objects[count - 1]);
+    free(objects);
+
+    // Thread de purge en arrière-plan
+    assert(valloc_scavenger_start(&allocator, 0, VALLOC_PURGE_DONTNEED) == -1);
+    assert(valloc_scavenger_start(&allocator, 10, VALLOC_PURGE_DONTNEED) == 0);
+    assert(valloc_scavenger_start(&allocator, 10, VALLOC_PURGE_DONTNEED) == -1);
+    revalloc(&allocator, again);
+    for (int i = 0; i < 200 && resident_pages(again, size) > 0; i++) {
+        usleep(10000);
+    }
+    assert(resident_pages(again, size) == 0);
+    valloc_scavenger_stop(&allocator);
+    assert(allocator.scavenger.purged_bytes >= 2 * size);
+
+    // Redémarrage en mode paresseux, puis arrêt par valloc_destroy
+    assert(valloc_scavenger_start(&allocator, 10, VALLOC_PURGE_FREE) == 0);
+    valloc_destroy(&allocator);
+    printf("✓ Test de la purge en arrière-plan réussi\n");
+}
+
+// Nombre de lignes d'un flux contenant un motif
+static int count_lines(FILE* stream, const char* pattern) {
+    char line[4096];
+    int count = 0;
+    rewind(stream);
+    while (fgets(line, sizeof(line), stream)) {
+        if (strstr(line, pattern)) count++;
+    }
+    return count;
+}
+
+void test_profiler() {
+    MemoryAllocator allocator;
+    assert(valloc_init(&allocator, 100, 2) == 0);
+
+    // Sans profileur, aucun échantillon
+    void* before = valloc_block(&allocator, 1024);
+    FILE* out = tmpfile();
+    assert(valloc_profile_dump(&allocator, out, VALLOC_PROFILE_TEXT) == 0);
+    fclose(out);
+    free_valloc(&allocator, before);
+
+    // 1 Mo alloué avec une période de 4 Ko : environ 256 échantillons
+    assert(valloc_profile_start(&allocator, 4096) == 0);
+    const size_t count = 4096;
+    void** objects = malloc(count * sizeof(void*));
+    for (size_t i = 0; i < count; i++) {
+        objects[i] = valloc_block(&allocator, 256);
+        assert(objects[i] != NULL);
+    }
+    void* large = valloc_block(&allocator, 8 * 1024 * 1024);
+    assert(large != NULL);
+
+    out = tmpfile();
+    int samples = valloc_profile_dump(&allocator, out, VALLOC_PROFILE_PPROF);
+    assert(samples > 100 && samples < 600);
+    assert(count_lines(out, "@ heap_v2/4096") == 1);
+    assert(count_lines(out, "1: 8388608 [1: 8388608] @") == 1);
+    assert(count_lines(out, "MAPPED_LIBRARIES:") == 1);
+    fclose(out);
+
+    out = tmpfile();
+    assert(valloc_profile_dump(&allocator, out, VALLOC_PROFILE_TEXT) == samples);
+    // Piles symbolisées : module + décalage, les symboles de l'exécutable n'étant pas exportés
+    assert(count_lines(out, "test_basic_operations+0x") >= 1);
+    fclose(out);
+
+    // Les libérations retirent les échantillons, même déplacés par realloc
+    large = valloc_realloc(&allocator, large, 32 * 1024 * 1024);
+    for (size_t i = 0; i < count; i++) {
+        free_valloc(&allocator, objects[i]);
+    }
+    out = tmpfile();
+    assert(valloc_profile_dump(&allocator, out, VALLOC_PROFILE_PPROF) == 1);
+    fclose(out);
+    revalloc(&allocator, large);
+    out = tmpfile();
+    assert(valloc_profile_dump(&allocator, out, VALLOC_PROFILE_PPROF) == 0);
+    fclose(out);
+
+    // Profil écrit sur signal par le thread dédié
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "/tmp/valloc_test_%d", (int)getpid());
+    assert(valloc_profile_signal(&allocator, SIGUSR2, prefix) == 0);
+    assert(valloc_profile_signal(&allocator, SIGUSR2, prefix) == -1);
+    raise(SIGUSR2);
+    char path[96];
+    snprintf(path, sizeof(path), "%s.0000.heap", prefix);
+    FILE* dumped = NULL;
+    for (int i = 0; i < 200 && dumped == NULL; i++) {
+        usleep(5000);
+        dumped = fopen(path, "r");
+        if (dumped && count_lines(dumped, "MAPPED_LIBRARIES:") == 0) {
+            fclose(dumped);
+            dumped = NULL;
+        }
+    }
+    assert(dumped != NULL);
+    assert(count_lines(dumped, "heap profile: 0: 0") == 1);
+    fclose(dumped);
+    unlink(path);
+
+    // Profileur arrêté : plus aucun échantillon
+    valloc_profile_stop(&allocator);
+    for (size_t i = 0; i < count; i++) {
+        objects[i] = valloc_block(&allocator, 256);
+    }
+    out = tmpfile();
+    assert(valloc_profile_dump(&allocator, out, VALLOC_PROFILE_TEXT) == 0);
+    fclose(out);
+    for (size_t i = 0; i < count; i++) {
+        free_valloc(&allocator, objects[i]);
+    }
+
+    free(objects);
+    valloc_destroy(&allocator);
+    printf("✓ Test du profileur de tas réussi\n");
+}
+
 int main() {
     printf("=== Tests des opérations de base ===\n");
     
     test_init_destroy();
     test_alloc_free();
     test_block_recycling();
+    test_recycling_best_fit();
+    test_large_cache();
+    test_slab_packing();
+    test_usable_size();
+    test_realloc();
+    test_aligned();
+    test_table_growth();
+    test_huge_pages();
+    test_scavenger();
+    test_profiler();
     
     printf("\nTous les tests ont réussi !\n");
     return 0;
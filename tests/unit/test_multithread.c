@@ -3,6 +3,7 @@
 #include <pthread.h>
 #include <assert.h>
 #include <string.h>
+#include <stdint.h>
 #include "valloc.h"
 
 #define NUM_THREADS 4
@@ -119,11 +120,286 @@ void test_concurrent_recycling() {
     printf("✓ Test de recyclage concurrent réussi\n");
 }
 
+#define NUM_WAVES 8
+#define WAVE_THREADS 16
+
+// Fonction exécutée par chaque thread éphémère
+void* churn_function(void* arg) {
+    ThreadArg* thread_arg = (ThreadArg*)arg;
+    thread_arg->success = get_thread_cache(thread_arg->allocator) != NULL;
+
+    for (int i = 0; i < NUM_ALLOCATIONS; i++) {
+        void* ptr = valloc_block(thread_arg->allocator, BLOCK_SIZE);
+        if (!ptr) {
+            thread_arg->success = 0;
+            return NULL;
+        }
+        memset(ptr, (char)thread_arg->thread_id, BLOCK_SIZE);
+        free_valloc(thread_arg->allocator, ptr);
+    }
+    return NULL;
+}
+
+// Test de rotation des threads : bien plus de threads que prévu à
+// l'initialisation, chacun obtient un cache et les indices sont réutilisés
+void test_thread_churn() {
+    MemoryAllocator allocator;
+    valloc_init(&allocator, NUM_THREADS * NUM_ALLOCATIONS, NUM_THREADS);
+
+    for (int wave = 0; wave < NUM_WAVES; wave++) {
+        pthread_t threads[WAVE_THREADS];
+        ThreadArg thread_args[WAVE_THREADS];
+
+        for (int i = 0; i < WAVE_THREADS; i++) {
+            thread_args[i].allocator = &allocator;
+            thread_args[i].thread_id = wave * WAVE_THREADS + i;
+            thread_args[i].success = 0;
+            assert(pthread_create(&threads[i], NULL, churn_function, &thread_args[i]) == 0);
+        }
+        for (int i = 0; i < WAVE_THREADS; i++) {
+            pthread_join(threads[i], NULL);
+            assert(thread_args[i].success == 1);
+        }
+    }
+
+    // Les caches des threads terminés ont été recyclés
+    assert(allocator.num_threads <= WAVE_THREADS);
+
+    valloc_destroy(&allocator);
+    printf("✓ Test de rotation des threads réussi\n");
+}
+
+#define NUMA_NODES 2
+#define NUMA_LARGE_SIZE (1024 * 1024)
+
+// Fonction exécutée par chaque thread d'un nœud simulé
+void* numa_function(void* arg) {
+    ThreadArg* thread_arg = (ThreadArg*)arg;
+    valloc_set_thread_node(thread_arg->thread_id);
+
+    thread_arg->blocks[0] = valloc_block(thread_arg->allocator, 64);
+    thread_arg->blocks[1] = valloc_block(thread_arg->allocator, NUMA_LARGE_SIZE);
+    thread_arg->success = thread_arg->blocks[0] != NULL && thread_arg->blocks[1] != NULL &&
+                          valloc_node_of(thread_arg->allocator, thread_arg->blocks[0]) == thread_arg->thread_id &&
+                          valloc_node_of(thread_arg->allocator, thread_arg->blocks[1]) == thread_arg->thread_id;
+    return NULL;
+}
+
+// Test des arènes NUMA sur une topologie simulée de deux nœuds
+void test_numa_arenas() {
+    MemoryAllocator allocator;
+    assert(valloc_init_flags(&allocator, 100, NUMA_NODES, VALLOC_NUMA) == 0);
+    assert(valloc_set_numa_nodes(&allocator, 0) == -1);
+    assert(valloc_set_numa_nodes(&allocator, VALLOC_MAX_NODES + 1) == -1);
+    assert(valloc_set_numa_nodes(&allocator, NUMA_NODES) == 0);
+
+    pthread_t threads[NUMA_NODES];
+    ThreadArg thread_args[NUMA_NODES];
+    void* blocks[NUMA_NODES][2];
+
+    for (int i = 0; i < NUMA_NODES; i++) {
+        thread_args[i].allocator = &allocator;
+        thread_args[i].thread_id = i;
+        thread_args[i].blocks = blocks[i];
+        thread_args[i].success = 0;
+        assert(pthread_create(&threads[i], NULL, numa_function, &thread_args[i]) == 0);
+    }
+    for (int i = 0; i < NUMA_NODES; i++) {
+        pthread_join(threads[i], NULL);
+        assert(thread_args[i].success == 1);
+    }
+
+    // Chaque nœud a ses propres chunks de slabs
+    uintptr_t chunk_mask = ~(uintptr_t)(SLAB_CHUNK_SIZE - 1);
+    assert(((uintptr_t)blocks[0][0] & chunk_mask) != ((uintptr_t)blocks[1][0] & chunk_mask));
+
+    // Un bloc libéré par un autre thread retourne à l'arène de son nœud
+    free_valloc(&allocator, blocks[1][1]);
+    valloc_set_thread_node(1);
+    void* reused = valloc_block(&allocator, NUMA_LARGE_SIZE);
+    assert(valloc_node_of(&allocator, reused) == 1);
+    valloc_set_thread_node(-1);
+    assert(valloc_node_of(&allocator, &allocator) == -1);
+
+    free_valloc(&allocator, reused);
+    for (int i = 0; i < NUMA_NODES; i++) {
+        free_valloc(&allocator, blocks[i][0]);
+    }
+    free_valloc(&allocator, blocks[0][1]);
+    valloc_destroy(&allocator);
+    printf("✓ Test des arènes NUMA réussi\n");
+}
+
+#define CLASS_THREADS 8
+#define CLASS_OBJECTS 2000
+
+// Fonction exécutée par chaque thread : objets de deux classes, sans cache,
+// chaque allocation et libération passe par les listes centrales
+void* class_function(void* arg) {
+    ThreadArg* thread_arg = (ThreadArg*)arg;
+    size_t sizes[2] = {16 + 16 * (size_t)thread_arg->thread_id, 1024};
+    unsigned char** objects = (unsigned char**)thread_arg->blocks;
+
+    for (int round = 0; round < 4; round++) {
+        for (int i = 0; i < CLASS_OBJECTS; i++) {
+            size_t size = sizes[i & 1];
+            objects[i] = valloc_block(thread_arg->allocator, size);
+            if (!objects[i]) return NULL;
+            memset(objects[i], thread_arg->thread_id, size);
+        }
+        for (int i = 0; i < CLASS_OBJECTS; i++) {
+            size_t size = sizes[i & 1];
+            for (size_t j = 0; j < size; j++) {
+                if (objects[i][j] != (unsigned char)thread_arg->thread_id) return NULL;
+            }
+            free_valloc(thread_arg->allocator, objects[i]);
+        }
+    }
+    thread_arg->success = 1;
+    return NULL;
+}
+
+// Test des listes centrales par classe : des threads sans cache se
+// partagent une arène, une classe propre à chacun et une classe commune
+void test_sharded_classes() {
+    MemoryAllocator allocator;
+    assert(valloc_init(&allocator, 100, 0) == 0);
+
+    pthread_t threads[CLASS_THREADS];
+    ThreadArg thread_args[CLASS_THREADS];
+    for (int i = 0; i < CLASS_THREADS; i++) {
+        thread_args[i].allocator = &allocator;
+        thread_args[i].thread_id = i;
+        thread_args[i].blocks = malloc(CLASS_OBJECTS * sizeof(void*));
+        thread_args[i].success = 0;
+        assert(pthread_create(&threads[i], NULL, class_function, &thread_args[i]) == 0);
+    }
+    for (int i = 0; i < CLASS_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        assert(thread_args[i].success == 1);
+        free(thread_args[i].blocks);
+    }
+
+    // Toutes les spans sont revenues à leurs chunks
+    valloc_cleanup(&allocator);
+    assert(allocator.used_blocks == 0);
+
+    valloc_destroy(&allocator);
+    printf("✓ Test des listes centrales par classe réussi\n");
+}
+
+#define PERCPU_THREADS 16
+
+// Libère un objet depuis un autre thread que celui qui l'a alloué
+void* free_function(void* arg) {
+    void** args = (void**)arg;
+    free_valloc((MemoryAllocator*)args[0], args[1]);
+    return NULL;
+}
+
+// Test des caches par processeur : les threads se partagent les caches de
+// leurs processeurs, aucun cache de thread n'est créé
+void test_percpu_caches() {
+    MemoryAllocator allocator;
+    assert(valloc_init_flags(&allocator, 100, PERCPU_THREADS, VALLOC_PERCPU) == 0);
+    if (!(allocator.flags & VALLOC_PERCPU)) {
+        valloc_destroy(&allocator);
+        printf("✓ Test des caches par processeur ignoré (rseq indisponible)\n");
+        return;
+    }
+
+    pthread_t threads[PERCPU_THREADS];
+    ThreadArg thread_args[PERCPU_THREADS];
+    for (int i = 0; i < PERCPU_THREADS; i++) {
+        thread_args[i].allocator = &allocator;
+        thread_args[i].thread_id = i;
+        thread_args[i].blocks = malloc(CLASS_OBJECTS * sizeof(void*));
+        thread_args[i].success = 0;
+        assert(pthread_create(&threads[i], NULL, class_function, &thread_args[i]) == 0);
+    }
+    for (int i = 0; i < PERCPU_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        assert(thread_args[i].success == 1);
+        free(thread_args[i].blocks);
+    }
+
+    VallocStats stats;
+    assert(valloc_stats(&allocator, &stats) == 0);
+    assert(stats.num_threads == 0);
+    assert(stats.cache_hits > 0);
+    assert(stats.cache_refills > 0);
+
+    // Objet alloué par un thread, libéré par un autre
+    void* ptr = valloc_block(&allocator, 64);
+    assert(ptr != NULL);
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, free_function, (void*[]){&allocator, ptr}) == 0);
+    pthread_join(thread, NULL);
+
+    valloc_destroy(&allocator);
+    printf("✓ Test des caches par processeur réussi\n");
+}
+
+#define PRODUCER_ROUNDS 10
+#define PRODUCER_OBJECTS 50000
+
+// Producteur éphémère : alloue puis se termine, ses blocs restent vivants
+void* producer_function(void* arg) {
+    ThreadArg* thread_arg = (ThreadArg*)arg;
+    thread_arg->success = 1;
+    for (int i = 0; i < PRODUCER_OBJECTS; i++) {
+        thread_arg->blocks[i] = valloc_block(thread_arg->allocator, 64);
+        if (!thread_arg->blocks[i]) {
+            thread_arg->success = 0;
+            return NULL;
+        }
+        memset(thread_arg->blocks[i], (char)i, 64);
+    }
+    return NULL;
+}
+
+// Test des producteurs terminés : les blocs libérés par le consommateur
+// après la fin de leur propriétaire retournent aux listes centrales
+void test_exited_producers() {
+    MemoryAllocator allocator;
+    assert(valloc_init(&allocator, 100, NUM_THREADS) == 0);
+    ThreadArg producer = {&allocator, 0, malloc(PRODUCER_OBJECTS * sizeof(void*)), 0};
+    assert(producer.blocks != NULL);
+
+    VallocStats stats;
+    size_t first_round = 0;
+    for (int round = 0; round < PRODUCER_ROUNDS; round++) {
+        pthread_t thread;
+        assert(pthread_create(&thread, NULL, producer_function, &producer) == 0);
+        pthread_join(thread, NULL);
+        assert(producer.success == 1);
+
+        for (int i = 0; i < PRODUCER_OBJECTS; i++) free_valloc(&allocator, producer.blocks[i]);
+        assert(valloc_stats(&allocator, &stats) == 0);
+        if (round == 0) first_round = stats.bytes_mapped;
+    }
+
+    // La mémoire projetée reste celle d'un tour
+    assert(stats.bytes_mapped <= first_round + first_round / 4);
+    valloc_cleanup(&allocator);
+    assert(valloc_stats(&allocator, &stats) == 0);
+    assert(stats.bytes_mapped <= first_round);
+
+    free(producer.blocks);
+    valloc_destroy(&allocator);
+    printf("✓ Test des producteurs terminés réussi\n");
+}
+
 int main() {
     printf("=== Tests multithread ===\n");
     
     test_concurrent_allocation();
     test_concurrent_recycling();
+    test_thread_churn();
+    test_numa_arenas();
+    test_sharded_classes();
+    test_percpu_caches();
+    test_exited_producers();
     
     printf("\nTous les tests ont réussi !\n");
     return 0;
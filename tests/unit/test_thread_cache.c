@@ -1,4 +1,7 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <pthread.h>
 #include <assert.h>
 #include "../../src/valloc.h"
@@ -34,6 +37,457 @@ void* test_thread(void* arg) {
     return NULL;
 }
 
+typedef struct {
+    ThreadCache* cache;
+    void* ptr;
+} RemoteArg;
+
+// Libère un bloc vers le cache d'un autre thread
+void* remote_free_thread(void* arg) {
+    RemoteArg* remote = (RemoteArg*)arg;
+    cache_free_remote(remote->cache, remote->ptr, BLOCK_SIZE);
+    return NULL;
+}
+
+// Libère avec sa taille un bloc alloué par le thread de cache
+void* sized_free_thread(void* arg) {
+    RemoteArg* remote = (RemoteArg*)arg;
+    free_valloc_sized(remote->cache->allocator, remote->ptr, BLOCK_SIZE);
+    return NULL;
+}
+
+// Libère un bloc alloué par un autre thread
+void* foreign_free_thread(void* arg) {
+    RemoteArg* remote = (RemoteArg*)arg;
+    free_valloc(&allocator, remote->ptr);
+    return NULL;
+}
+
+// Test du canal de libération distante : le bloc rendu par un autre
+// thread est récupéré par le propriétaire à son allocation suivante
+void test_remote_free() {
+    MemoryAllocator remote_allocator;
+    assert(valloc_init(&remote_allocator, INITIAL_BLOCKS, MAX_THREADS) == 0);
+
+    ThreadCache* cache = get_thread_cache(&remote_allocator);
+    assert(cache != NULL);
+
+    void* ptr = valloc_block(&remote_allocator, BLOCK_SIZE);
+    assert(ptr != NULL);
+
+    pthread_t thread;
+    RemoteArg remote = {cache, ptr};
+    assert(pthread_create(&thread, NULL, remote_free_thread, &remote) == 0);
+    pthread_join(thread, NULL);
+
+    assert(valloc_block(&remote_allocator, BLOCK_SIZE) == ptr);
+    free_valloc(&remote_allocator, ptr);
+
+    valloc_destroy(&remote_allocator);
+    printf("Remote free test completed successfully\n");
+}
+
+// Test de la libération par un autre thread : le bloc revient au
+// thread qui l'a alloué et non à celui qui le libère
+void test_foreign_free() {
+    valloc_destroy(&allocator);
+    assert(valloc_init(&allocator, INITIAL_BLOCKS, MAX_THREADS) == 0);
+
+    void* small = valloc_block(&allocator, BLOCK_SIZE);
+    void* large = valloc_block(&allocator, 100000);
+    assert(small != NULL && large != NULL);
+
+    pthread_t thread;
+    RemoteArg remote = {NULL, small};
+    assert(pthread_create(&thread, NULL, foreign_free_thread, &remote) == 0);
+    pthread_join(thread, NULL);
+    remote.ptr = large;
+    assert(pthread_create(&thread, NULL, foreign_free_thread, &remote) == 0);
+    pthread_join(thread, NULL);
+
+    assert(valloc_block(&allocator, BLOCK_SIZE) == small);
+    assert(valloc_block(&allocator, 100000) == large);
+
+    valloc_destroy(&allocator);
+    printf("Foreign free test completed successfully\n");
+}
+
+// Test de la réutilisation par classe de taille : un bloc en cache sert
+// toute demande de sa classe, pas seulement la taille exacte
+void test_size_class_reuse() {
+    MemoryAllocator class_allocator;
+    assert(valloc_init(&class_allocator, INITIAL_BLOCKS, MAX_THREADS) == 0);
+
+    void* small = valloc_block(&class_allocator, 1024);
+    assert(small != NULL);
+    free_valloc(&class_allocator, small);
+    assert(valloc_block(&class_allocator, 1000) == small);
+
+    void* large = valloc_block(&class_allocator, 100000);
+    assert(large != NULL);
+    free_valloc(&class_allocator, large);
+    assert(valloc_block(&class_allocator, 90000) == large);
+
+    assert(valloc_set_cache_depth(&class_allocator, 1024, 0) == 0);
+    assert(valloc_set_cache_depth(&class_allocator, CACHE_MAX_SIZE * 2, 1) == -1);
+
+    free_valloc(&class_allocator, small);
+    free_valloc(&class_allocator, large);
+    valloc_destroy(&class_allocator);
+    printf("Size class reuse test completed successfully\n");
+}
+
+#define STATS_OBJECTS 10
+
+// Fonction exécutée par un second thread : ses compteurs s'ajoutent au total
+void* stats_thread(void* arg) {
+    MemoryAllocator* stats_allocator = (MemoryAllocator*)arg;
+    free_valloc(stats_allocator, valloc_block(stats_allocator, 50));
+    return NULL;
+}
+
+// Test des statistiques : classes, succès du cache, octets et appels système
+void test_stats() {
+    MemoryAllocator stats_allocator;
+    assert(valloc_init(&stats_allocator, INITIAL_BLOCKS, 1) == 0);
+    VallocStats stats;
+
+    // Le premier échec remplit le cache d'un lot : tout le reste est servi par lui
+    void* objects[STATS_OBJECTS];
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < STATS_OBJECTS; i++) objects[i] = valloc_block(&stats_allocator, 50);
+        for (int i = 0; i < STATS_OBJECTS; i++) free_valloc(&stats_allocator, objects[i]);
+    }
+    assert(valloc_stats(&stats_allocator, &stats) == 0);
+    assert(stats.allocs == 2 * STATS_OBJECTS);
+    assert(stats.class_allocs[3] == 2 * STATS_OBJECTS);  // classe de 64 octets
+    assert(stats.cache_misses == 1 && stats.cache_hits == 2 * STATS_OBJECTS - 1);
+    assert(stats.cache_refills == 1 && stats.cache_flushes == 0);
+    assert(stats.frees == 2 * STATS_OBJECTS);
+    assert(stats.bytes_requested == 2 * STATS_OBJECTS * 50);
+    assert(stats.bytes_allocated == 2 * STATS_OBJECTS * 64);
+    assert(stats.num_threads == 1);
+    assert(stats.global_contention == 0 && stats.arena_contention == 0);
+
+    // Grand bloc hors cache : une projection, conservée à la libération pour
+    // la demande suivante, rendue par le nettoyage
+    size_t mapped = stats.bytes_mapped;
+    uint64_t mmaps = stats.mmap_calls;
+    void* large = valloc_block(&stats_allocator, CACHE_MAX_SIZE + 1);
+    assert(valloc_stats(&stats_allocator, &stats) == 0);
+    assert(stats.class_allocs[NUM_STATS_CLASSES - 1] == 1);
+    assert(stats.mmap_calls == mmaps + 1);
+    assert(stats.bytes_mapped > mapped && stats.bytes_mapped_peak >= stats.bytes_mapped);
+    free_valloc(&stats_allocator, large);
+    assert(valloc_stats(&stats_allocator, &stats) == 0);
+    assert(stats.bytes_recycled >= CACHE_MAX_SIZE + 1 && stats.bytes_mapped > mapped);
+    large = valloc_block(&stats_allocator, CACHE_MAX_SIZE + 1);
+    assert(valloc_stats(&stats_allocator, &stats) == 0);
+    assert(stats.mmap_calls == mmaps + 1 && stats.large_reuses == 1 && stats.bytes_recycled == 0);
+    free_valloc(&stats_allocator, large);
+    // Le nettoyage rend aussi le chunk des petits objets, redevenu vide
+    valloc_cleanup(&stats_allocator);
+    assert(valloc_stats(&stats_allocator, &stats) == 0);
+    assert(stats.bytes_recycled == 0 && stats.bytes_mapped <= mapped && stats.munmap_calls >= 1);
+
+    // Les compteurs des autres threads sont additionnés
+    pthread_t thread;
+    assert(pthread_create(&thread, NULL, stats_thread, &stats_allocator) == 0);
+    pthread_join(thread, NULL);
+    assert(valloc_stats(&stats_allocator, &stats) == 0);
+    assert(stats.allocs == 2 * STATS_OBJECTS + 3 && stats.num_threads == 2);
+
+    FILE* out = tmpfile();
+    assert(out != NULL);
+    valloc_stats_print(&stats_allocator, out);
+    assert(ftell(out) > 0);
+    fclose(out);
+    assert(valloc_stats(NULL, &stats) == -1);
+
+    valloc_destroy(&stats_allocator);
+    printf("Stats test completed successfully\n");
+}
+
+#define BATCH_OBJECTS 100
+#define BATCH_LARGE 8
+
+// Test des transferts par lots : un échec remplit la moitié de la liste,
+// un cache plein en rend la moitié aux listes centrales et non au système
+void test_batch_transfer() {
+    MemoryAllocator batch_allocator;
+    assert(valloc_init(&batch_allocator, INITIAL_BLOCKS, 1) == 0);
+    VallocStats stats;
+
+    // 100 petits objets : un échec tous les lots de MAX_CACHE_BLOCKS / 2
+    void* objects[BATCH_OBJECTS];
+    for (int i = 0; i < BATCH_OBJECTS; i++) {
+        objects[i] = valloc_block(&batch_allocator, 64);
+        assert(objects[i] != NULL);
+    }
+    const uint32_t batch = MAX_CACHE_BLOCKS / 2;
+    assert(valloc_stats(&batch_allocator, &stats) == 0);
+    assert(stats.cache_misses == (BATCH_OBJECTS + batch) / (batch + 1));
+    assert(stats.cache_refills == stats.cache_misses);
+
+    // Les libérations débordent par lots ; le cache reste entre la moitié et le plein
+    for (int i = 0; i < BATCH_OBJECTS; i++) free_valloc(&batch_allocator, objects[i]);
+    ThreadCache* cache = get_thread_cache(&batch_allocator);
+    uint32_t count = cache->bins[3].count;
+    assert(count > batch && count <= MAX_CACHE_BLOCKS);
+    assert(valloc_stats(&batch_allocator, &stats) == 0);
+    assert(stats.cache_flushes >= (BATCH_OBJECTS - MAX_CACHE_BLOCKS) / batch);
+
+    // Grands blocs : le débordement les recycle sans munmap
+    void* large[BATCH_LARGE];
+    for (int i = 0; i < BATCH_LARGE; i++) large[i] = valloc_block(&batch_allocator, 100000);
+    assert(valloc_stats(&batch_allocator, &stats) == 0);
+    uint64_t munmaps = stats.munmap_calls;
+    for (int i = 0; i < BATCH_LARGE; i++) free_valloc(&batch_allocator, large[i]);
+    assert(valloc_stats(&batch_allocator, &stats) == 0);
+    assert(stats.munmap_calls == munmaps);
+    assert(stats.recycled_blocks == BATCH_LARGE - MAX_CACHE_LARGE_BLOCKS);
+
+    // Puis ressortent des classes de recyclage
+    for (int i = 0; i < BATCH_LARGE; i++) {
+        large[i] = valloc_block(&batch_allocator, 100000);
+        assert(large[i] != NULL);
+    }
+    assert(valloc_stats(&batch_allocator, &stats) == 0);
+    assert(stats.recycled_blocks == 0);
+    for (int i = 0; i < BATCH_LARGE; i++) free_valloc(&batch_allocator, large[i]);
+
+    valloc_destroy(&batch_allocator);
+    printf("Batch transfer test completed successfully\n");
+}
+
+#define BATCH_API_OBJECTS 200
+
+// Test des lots explicites : blocs distincts, une traversée du cache puis
+// de la classe, et retour complet aux listes centrales
+void test_batch_api() {
+    MemoryAllocator batch_allocator;
+    assert(valloc_init(&batch_allocator, INITIAL_BLOCKS, 1) == 0);
+    VallocStats stats;
+
+    void* objects[BATCH_API_OBJECTS];
+    assert(valloc_batch(&batch_allocator, 64, BATCH_API_OBJECTS, objects) == BATCH_API_OBJECTS);
+    for (int i = 0; i < BATCH_API_OBJECTS; i++) {
+        assert(objects[i] != NULL);
+        assert(valloc_usable_size(&batch_allocator, objects[i]) >= 64);
+        memset(objects[i], i, 64);
+    }
+    for (int i = 0; i < BATCH_API_OBJECTS; i++) {
+        for (int j = 0; j < 64; j++) assert(((unsigned char*)objects[i])[j] == (unsigned char)i);
+    }
+    assert(valloc_stats(&batch_allocator, &stats) == 0);
+    assert(stats.allocs == BATCH_API_OBJECTS);
+    assert(stats.cache_hits + stats.cache_misses == BATCH_API_OBJECTS);
+    assert(stats.bytes_requested == 64 * BATCH_API_OBJECTS);
+
+    // Le cache garde ce qu'il peut, le reste retourne aux spans en un lot
+    free_valloc_batch(&batch_allocator, objects, BATCH_API_OBJECTS);
+    ThreadCache* cache = get_thread_cache(&batch_allocator);
+    assert(cache->bins[3].count == MAX_CACHE_BLOCKS);
+    assert(valloc_stats(&batch_allocator, &stats) == 0);
+    assert(stats.frees == BATCH_API_OBJECTS);
+    assert(stats.cache_flushes == 1);
+
+    // Le lot suivant commence par les blocs du cache
+    assert(valloc_batch(&batch_allocator, 64, BATCH_API_OBJECTS, objects) == BATCH_API_OBJECTS);
+    assert(valloc_stats(&batch_allocator, &stats) == 0);
+    assert(stats.cache_hits == MAX_CACHE_BLOCKS);
+    free_valloc_batch(&batch_allocator, objects, BATCH_API_OBJECTS);
+
+    // Grands blocs : un par un, par les chemins habituels
+    void* large[BATCH_LARGE];
+    assert(valloc_batch(&batch_allocator, 100000, BATCH_LARGE, large) == BATCH_LARGE);
+    for (int i = 0; i < BATCH_LARGE; i++) memset(large[i], 0, 100000);
+    free_valloc_batch(&batch_allocator, large, BATCH_LARGE);
+    valloc_destroy(&batch_allocator);
+
+    // Sans cache : tout passe par les listes centrales, et y retourne
+    MemoryAllocator central_allocator;
+    assert(valloc_init(&central_allocator, INITIAL_BLOCKS, 0) == 0);
+    assert(valloc_batch(&central_allocator, 200, BATCH_API_OBJECTS, objects) == BATCH_API_OBJECTS);
+    objects[0] = NULL;
+    free_valloc_batch(&central_allocator, objects, BATCH_API_OBJECTS);
+    assert(valloc_stats(&central_allocator, &stats) == 0);
+    assert(stats.frees == BATCH_API_OBJECTS - 1);
+    valloc_destroy(&central_allocator);
+    printf("Batch API test completed successfully\n");
+}
+
+#define SIZED_OBJECTS 100
+
+// Test des libérations avec taille : retour direct au cache de la classe,
+// tailles erronées détectées par le mode de vérification
+void test_sized_free() {
+    MemoryAllocator sized_allocator;
+    assert(valloc_init_flags(&sized_allocator, INITIAL_BLOCKS, 1, VALLOC_DEBUG_SIZED) == 0);
+    VallocStats stats;
+
+    // Chaque classe de petits objets retrouve ses blocs dans le cache
+    static const size_t sizes[] = {16, 100, 1000, SLAB_MAX_SIZE};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        void* objects[SIZED_OBJECTS];
+        for (int i = 0; i < SIZED_OBJECTS; i++) {
+            objects[i] = valloc_block(&sized_allocator, sizes[s]);
+            assert(objects[i] != NULL);
+        }
+        for (int i = 0; i < SIZED_OBJECTS; i++) free_valloc_sized(&sized_allocator, objects[i], sizes[s]);
+        void* again = valloc_block(&sized_allocator, sizes[s]);
+        assert(again == objects[SIZED_OBJECTS - 1]);
+        free_valloc_sized(&sized_allocator, again, sizes[s]);
+    }
+    assert(valloc_stats(&sized_allocator, &stats) == 0);
+    assert(stats.sized_mismatches == 0);
+    assert(stats.frees == stats.allocs);
+
+    // Taille erronée : comptée, et le bloc libéré d'après ses métadonnées
+    void* ptr = valloc_block(&sized_allocator, 64);
+    free_valloc_sized(&sized_allocator, ptr, 512);
+    assert(valloc_stats(&sized_allocator, &stats) == 0);
+    assert(stats.sized_mismatches == 1);
+    assert(valloc_block(&sized_allocator, 64) == ptr);
+    free_valloc_sized(&sized_allocator, ptr, 64);
+
+    // Taille d'une classe plus petite : comptée aussi
+    ptr = valloc_block(&sized_allocator, 256);
+    free_valloc_sized(&sized_allocator, ptr, 64);
+    assert(valloc_stats(&sized_allocator, &stats) == 0);
+    assert(stats.sized_mismatches == 2);
+    assert(valloc_block(&sized_allocator, 256) == ptr);
+
+    // Réduction en place, bloc aligné annoncé avec sa taille utilisable : admis
+    assert(valloc_realloc(&sized_allocator, ptr, 200) == ptr);
+    free_valloc_sized(&sized_allocator, ptr, 200);
+    ptr = valloc_aligned(&sized_allocator, 64, 256);
+    free_valloc_sized(&sized_allocator, ptr, valloc_usable_size(&sized_allocator, ptr));
+    assert(valloc_stats(&sized_allocator, &stats) == 0);
+    assert(stats.sized_mismatches == 2);
+
+    // Grands blocs : chemin de free_valloc
+    ptr = valloc_block(&sized_allocator, 100000);
+    free_valloc_sized(&sized_allocator, ptr, 100000);
+    assert(valloc_stats(&sized_allocator, &stats) == 0);
+    assert(stats.sized_mismatches == 2);
+    assert(stats.frees == stats.allocs);
+    valloc_destroy(&sized_allocator);
+
+    // Sans vérification : un objet réduit par valloc_realloc, ou aligné,
+    // retourne à sa classe réelle et non à celle de la taille annoncée
+    assert(valloc_init(&sized_allocator, INITIAL_BLOCKS, 1) == 0);
+    ptr = valloc_block(&sized_allocator, 200);
+    assert(valloc_realloc(&sized_allocator, ptr, 120) == ptr);
+    free_valloc_sized(&sized_allocator, ptr, 120);
+    void* other = valloc_block(&sized_allocator, 120);
+    assert(other != ptr);
+    assert(valloc_block(&sized_allocator, 200) == ptr);
+    free_valloc_sized(&sized_allocator, other, 120);
+    free_valloc_sized(&sized_allocator, ptr, 200);
+
+    ptr = valloc_aligned(&sized_allocator, 64, 256);
+    assert(ptr != NULL && (uintptr_t)ptr % 256 == 0);
+    free_valloc_sized(&sized_allocator, ptr, 64);
+    other = valloc_block(&sized_allocator, 64);
+    assert(other != ptr);
+    assert(valloc_block(&sized_allocator, valloc_usable_size(&sized_allocator, ptr)) == ptr);
+    free_valloc_sized(&sized_allocator, other, 64);
+    free_valloc(&sized_allocator, ptr);
+
+    // Libéré par un autre thread : rendu au cache de son propriétaire
+    ptr = valloc_block(&sized_allocator, BLOCK_SIZE);
+    pthread_t thread;
+    RemoteArg remote = {get_thread_cache(&sized_allocator), ptr};
+    assert(pthread_create(&thread, NULL, sized_free_thread, &remote) == 0);
+    pthread_join(thread, NULL);
+    assert(valloc_stats(&sized_allocator, &stats) == 0);
+    assert(stats.remote_frees == 1);
+    assert(valloc_block(&sized_allocator, BLOCK_SIZE) == ptr);
+    free_valloc_sized(&sized_allocator, ptr, BLOCK_SIZE);
+    valloc_destroy(&sized_allocator);
+    printf("Sized free test completed successfully\n");
+}
+
+#define PRIVATE_ROUNDS 200
+#define PRIVATE_OBJECTS 2000
+
+typedef struct {
+    MemoryAllocator* allocator;
+    pthread_barrier_t* barrier;
+    void** blocks;
+    int count;
+} OwnerArg;
+
+// Alloue et libère ses propres objets, en alternance avec l'autre thread
+void* private_thread(void* arg) {
+    OwnerArg* owner = (OwnerArg*)arg;
+    for (int round = 0; round < PRIVATE_ROUNDS; round++) {
+        for (int i = 0; i < owner->count; i++) {
+            owner->blocks[i] = valloc_block(owner->allocator, 64);
+            assert(owner->blocks[i] != NULL);
+        }
+        pthread_barrier_wait(owner->barrier);
+        for (int i = 0; i < owner->count; i++) free_valloc(owner->allocator, owner->blocks[i]);
+    }
+    return NULL;
+}
+
+// Producteur qui alloue puis reste bloqué pendant que ses blocs sont libérés
+void* idle_producer_thread(void* arg) {
+    OwnerArg* owner = (OwnerArg*)arg;
+    for (int i = 0; i < owner->count; i++) {
+        owner->blocks[i] = valloc_block(owner->allocator, 64);
+        assert(owner->blocks[i] != NULL);
+    }
+    pthread_barrier_wait(owner->barrier);
+    pthread_barrier_wait(owner->barrier);
+    return NULL;
+}
+
+// Test de la propriété des spans : des threads qui se partagent les spans
+// d'une classe libèrent leurs propres objets localement, et la pile
+// distante d'un producteur inactif reste bornée
+void test_span_ownership() {
+    MemoryAllocator owner_allocator;
+    assert(valloc_init(&owner_allocator, INITIAL_BLOCKS, 2) == 0);
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, 2);
+
+    pthread_t threads[2];
+    OwnerArg args[2];
+    for (int t = 0; t < 2; t++) {
+        args[t] = (OwnerArg){&owner_allocator, &barrier, malloc(PRIVATE_OBJECTS * sizeof(void*)), PRIVATE_OBJECTS};
+        assert(pthread_create(&threads[t], NULL, private_thread, &args[t]) == 0);
+    }
+    for (int t = 0; t < 2; t++) {
+        pthread_join(threads[t], NULL);
+        free(args[t].blocks);
+    }
+    VallocStats stats;
+    assert(valloc_stats(&owner_allocator, &stats) == 0);
+    assert(stats.frees == 2 * PRIVATE_ROUNDS * PRIVATE_OBJECTS);
+    assert(stats.remote_frees == 0);
+    valloc_destroy(&owner_allocator);
+
+    // Au-delà de MAX_REMOTE_BLOCKS en attente, les blocs vont aux listes centrales
+    assert(valloc_init(&owner_allocator, INITIAL_BLOCKS, 2) == 0);
+    OwnerArg producer = {&owner_allocator, &barrier, malloc(3 * MAX_REMOTE_BLOCKS * sizeof(void*)),
+                         3 * MAX_REMOTE_BLOCKS};
+    assert(pthread_create(&threads[0], NULL, idle_producer_thread, &producer) == 0);
+    pthread_barrier_wait(&barrier);
+    for (int i = 0; i < producer.count; i++) free_valloc(&owner_allocator, producer.blocks[i]);
+    assert(valloc_stats(&owner_allocator, &stats) == 0);
+    assert(stats.remote_frees == MAX_REMOTE_BLOCKS);
+    pthread_barrier_wait(&barrier);
+    pthread_join(threads[0], NULL);
+    free(producer.blocks);
+
+    pthread_barrier_destroy(&barrier);
+    valloc_destroy(&owner_allocator);
+    printf("Span ownership test completed successfully\n");
+}
+
 int main() {
     pthread_t threads[NUM_THREADS];
     int thread_nums[NUM_THREADS];
@@ -60,6 +514,15 @@ int main() {
 
     // Nettoyage
     valloc_cleanup(&allocator);
+
+    test_remote_free();
+    test_size_class_reuse();
+    test_foreign_free();
+    test_stats();
+    test_batch_transfer();
+    test_batch_api();
+    test_sized_free();
+    test_span_ownership();
     printf("All tests passed successfully!\n");
     return 0;
 }
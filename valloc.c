@@ -4,147 +4,384 @@
 #include <stdio.h>
 #include <errno.h>
 #include <limits.h>
-#include <math.h>
-
-static memory_manager_t memory_manager = {0};
+#include <stdint.h>
 
 
 static int get_size_class(size_t size) {
-    if (size < MIN_BLOCK_SIZE) return 0;
-    int class = (int)(log2(size - 1)) - 3;  
-    if (class >= NUM_SIZE_CLASSES) return NUM_SIZE_CLASSES - 1;
+    if (size <= VA_MIN_BLOCK_SIZE) return 0;
+    // Arrondi à la puissance de 2 supérieure : 2^(class + 4) >= size
+    int class = (int)(sizeof(unsigned long) * CHAR_BIT) - __builtin_clzl(size - 1) - 4;
+    if (class >= VA_NUM_SIZE_CLASSES) return VA_NUM_SIZE_CLASSES - 1;
     return class;
 }
 
 
 static size_t get_block_size(int size_class) {
-    return 1 << (size_class + 4);  
+    return 1 << (size_class + 4);
+}
+
+// Taille totale d'un bloc, en-tête compris : une puissance de 2 pour les blocs du tas
+static size_t block_total_size(block_header_t* block) {
+    return block->size + sizeof(block_header_t);
 }
 
-void init_vallocator(void) {
-    size_t initial_size = MAX_BLOCK_SIZE * 4;  
-    void* heap = mmap(NULL, initial_size,
-                     PROT_READ | PROT_WRITE,
-                     MAP_PRIVATE | MAP_ANONYMOUS,
-                     -1, 0);
-    
-    if (heap == MAP_FAILED) {
+// Retire un bloc libre de sa liste en O(1) grâce à prev/next
+static void unlink_free_block(memory_manager_t* manager, block_header_t* block) {
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        manager->free_lists[get_size_class(block_total_size(block))] = block->next;
+    }
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+    block->next = NULL;
+    block->prev = NULL;
+}
+
+// Fusionne le bloc avec son compagnon tant que celui-ci est libre et entier.
+// Les chunks sont alignés sur leur taille : le début du chunk se déduit de
+// l'adresse du bloc. Verrou du gestionnaire pris
+static block_header_t* coalesce_block(memory_manager_t* manager, block_header_t* block) {
+    char* heap = (char*)((uintptr_t)block & ~(uintptr_t)(VA_HEAP_CHUNK_SIZE - 1));
+
+    // L'en-tête du chunk n'est jamais libre : la fusion s'arrête à la moitié du chunk
+    size_t total = block_total_size(block);
+    while (total < VA_HEAP_CHUNK_SIZE) {
+        // Le compagnon d'un bloc de taille 2^k est à l'offset de ce bloc XOR 2^k
+        size_t offset = (size_t)((char*)block - heap);
+        block_header_t* buddy = (block_header_t*)(heap + (offset ^ total));
+        if (!buddy->is_free || block_total_size(buddy) != total) break;
+
+        unlink_free_block(manager, buddy);
+        if (buddy < block) block = buddy;
+        total *= 2;
+        block->size = total - sizeof(block_header_t);
+    }
+    return block;
+}
+
+static void push_free_block(memory_manager_t* manager, block_header_t* block) {
+    block = coalesce_block(manager, block);
+    int size_class = get_size_class(block_total_size(block));
+    block->is_free = 1;
+    block->next = manager->free_lists[size_class];
+    block->prev = NULL;
+
+    if (manager->free_lists[size_class]) {
+        manager->free_lists[size_class]->prev = block;
+    }
+    manager->free_lists[size_class] = block;
+}
+
+// Rend les blocs d'un cache aux listes libres ; verrou du gestionnaire pris
+static void flush_cache_locked(thread_cache_t* cache) {
+    for (int i = 0; i < VA_NUM_SIZE_CLASSES; i++) {
+        while (cache->blocks[i]) {
+            block_header_t* block = cache->blocks[i];
+            cache->blocks[i] = block->next;
+            push_free_block(cache->manager, block);
+        }
+        cache->counts[i] = 0;
+    }
+}
+
+// Destructeur de la clé : le cache d'un thread qui se termine est rendu au gestionnaire
+static void release_thread_cache(void* arg) {
+    thread_cache_t* cache = (thread_cache_t*)arg;
+    memory_manager_t* manager = cache->manager;
+
+    pthread_mutex_lock(&manager->lock);
+    flush_cache_locked(cache);
+    thread_cache_t** link = &manager->caches;
+    while (*link != cache) link = &(*link)->next;
+    *link = cache->next;
+    pthread_mutex_unlock(&manager->lock);
+
+    munmap(cache, sizeof(thread_cache_t));
+}
+
+// Cache du thread courant, créé au premier appel (NULL si mmap échoue)
+static thread_cache_t* get_thread_cache(memory_manager_t* manager) {
+    thread_cache_t* cache = pthread_getspecific(manager->cache_key);
+    if (cache) return cache;
+
+    // Pris à mmap : le cache ne dépend pas d'un autre allocateur
+    void* ptr = mmap(NULL, sizeof(thread_cache_t),
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+    if (ptr == MAP_FAILED) return NULL;
+
+    cache = (thread_cache_t*)ptr;
+    cache->manager = manager;
+    pthread_mutex_lock(&manager->lock);
+    cache->next = manager->caches;
+    manager->caches = cache;
+    pthread_mutex_unlock(&manager->lock);
+    pthread_setspecific(manager->cache_key, cache);
+    return cache;
+}
+
+// Projette un chunk aligné sur sa taille et verse ses blocs dans free_lists ;
+// verrou du gestionnaire pris (ou gestionnaire pas encore partagé)
+static int add_chunk(memory_manager_t* manager) {
+    // Projection du double, puis retrait des parties non alignées
+    void* ptr = mmap(NULL, VA_HEAP_CHUNK_SIZE * 2,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+    if (ptr == MAP_FAILED) {
+        return -1;
+    }
+    uintptr_t start = ((uintptr_t)ptr + VA_HEAP_CHUNK_SIZE - 1) & ~(uintptr_t)(VA_HEAP_CHUNK_SIZE - 1);
+    size_t head = start - (uintptr_t)ptr;
+    if (head) munmap(ptr, head);
+    munmap((char*)start + VA_HEAP_CHUNK_SIZE, VA_HEAP_CHUNK_SIZE - head);
+
+    // L'en-tête occupe le plus petit bloc qui le contient, au début du chunk
+    char* heap = (char*)start;
+    heap_chunk_t* chunk = (heap_chunk_t*)heap;
+    size_t header_size = get_block_size(get_size_class(sizeof(heap_chunk_t)));
+    chunk->header.size = header_size - sizeof(block_header_t);
+    chunk->header.is_free = 0;
+    chunk->header.next = NULL;
+    chunk->header.prev = NULL;
+    chunk->next = manager->chunks;
+    manager->chunks = chunk;
+    manager->chunk_count++;
+
+    // Le reste du chunk : un compagnon libre par taille, de header_size à VA_HEAP_CHUNK_SIZE / 2
+    for (size_t size = header_size; size < VA_HEAP_CHUNK_SIZE; size *= 2) {
+        block_header_t* block = (block_header_t*)(heap + size);
+        block->size = size - sizeof(block_header_t);
+        block->next = NULL;
+        block->prev = NULL;
+        push_free_block(manager, block);
+    }
+    return 0;
+}
+
+int init_vallocator(memory_manager_t* manager) {
+    for (int i = 0; i < VA_NUM_SIZE_CLASSES; i++) {
+        manager->free_lists[i] = NULL;
+    }
+    manager->chunks = NULL;
+    manager->chunk_count = 0;
+    manager->large_blocks = NULL;
+    manager->caches = NULL;
+
+    // Premier chunk du tas, les suivants sont projetés à la demande
+    if (add_chunk(manager) != 0) {
         perror("Failed to initialize allocator");
-        return;
+        return -1;
     }
 
-    memory_manager.heap_start = heap;
-    
-    // Initialiser le premier bloc
-    block_header_t* initial_block = (block_header_t*)heap;
-    initial_block->size = initial_size - sizeof(block_header_t);
-    initial_block->is_free = 1;
-    initial_block->next = NULL;
-    initial_block->prev = NULL;
-    
-    // Placer dans la plus grande classe de taille
-    memory_manager.free_lists[NUM_SIZE_CLASSES - 1] = initial_block;
+    if (pthread_key_create(&manager->cache_key, release_thread_cache) != 0) {
+        munmap(manager->chunks, VA_HEAP_CHUNK_SIZE);
+        return -1;
+    }
+    pthread_mutex_init(&manager->lock, NULL);
+    manager->initialized = 1;
+    return 0;
 }
 
-static void split_block(block_header_t* block, int target_size_class) {
-    size_t current_size = block->size;
+// Divise le bloc par moitiés jusqu'à la classe visée ; verrou du gestionnaire pris
+static void split_block(memory_manager_t* manager, block_header_t* block, int target_size_class) {
+    size_t current_size = block_total_size(block);
     size_t target_size = get_block_size(target_size_class);
-    
+
     while (current_size >= target_size * 2) {
         size_t new_size = current_size / 2;
-        block_header_t* new_block = (block_header_t*)((char*)block + new_size + sizeof(block_header_t));
-        
+        block_header_t* new_block = (block_header_t*)((char*)block + new_size);
+
         new_block->size = new_size - sizeof(block_header_t);
         new_block->is_free = 1;
         new_block->next = NULL;
         new_block->prev = NULL;
-        
+
         block->size = new_size - sizeof(block_header_t);
-        
+
         // Ajouter le nouveau bloc à la liste appropriée
         int new_class = get_size_class(new_size);
-        new_block->next = memory_manager.free_lists[new_class];
-        if (memory_manager.free_lists[new_class]) {
-            memory_manager.free_lists[new_class]->prev = new_block;
+        new_block->next = manager->free_lists[new_class];
+        if (manager->free_lists[new_class]) {
+            manager->free_lists[new_class]->prev = new_block;
         }
-        memory_manager.free_lists[new_class] = new_block;
-        
+        manager->free_lists[new_class] = new_block;
+
         current_size = new_size;
     }
 }
 
-void* valloc(size_t size) {
+// Grand bloc : une projection dédiée, suivie dans large_blocks pour le nettoyage
+static void* valloc_large(memory_manager_t* manager, size_t size) {
+    size_t total_size = size + sizeof(block_header_t);
+    void* ptr = mmap(NULL, total_size,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+    if (ptr == MAP_FAILED) {
+        return NULL;
+    }
+
+    block_header_t* block = (block_header_t*)ptr;
+    block->size = size;
+    block->is_free = 0;
+    block->prev = NULL;
+    pthread_mutex_lock(&manager->lock);
+    block->next = manager->large_blocks;
+    if (manager->large_blocks) {
+        manager->large_blocks->prev = block;
+    }
+    manager->large_blocks = block;
+    pthread_mutex_unlock(&manager->lock);
+
+    return (void*)((char*)block + sizeof(block_header_t));
+}
+
+static void vafree_large(memory_manager_t* manager, block_header_t* block) {
+    pthread_mutex_lock(&manager->lock);
+    if (block->prev) {
+        block->prev->next = block->next;
+    } else {
+        manager->large_blocks = block->next;
+    }
+    if (block->next) {
+        block->next->prev = block->prev;
+    }
+    pthread_mutex_unlock(&manager->lock);
+
+    munmap(block, block_total_size(block));
+}
+
+void* valloc_alloc(memory_manager_t* manager, size_t size) {
     if (size == 0) return NULL;
-    
+
+    // Au-delà de la plus grande classe : grands blocs
+    size_t total_size = size + sizeof(block_header_t);
+    if (total_size > VA_MAX_BLOCK_SIZE) {
+        return valloc_large(manager, size);
+    }
+
     // Trouver la classe de taille appropriée
-    int size_class = get_size_class(size + sizeof(block_header_t));
-    
-    // Chercher un bloc libre dans la classe appropriée
-    for (int i = size_class; i < NUM_SIZE_CLASSES; i++) {
-        if (memory_manager.free_lists[i] != NULL) {
-            block_header_t* block = memory_manager.free_lists[i];
-            
+    int size_class = get_size_class(total_size);
+
+    // Bloc de la même classe libéré par ce thread : pas de verrou
+    thread_cache_t* cache = get_thread_cache(manager);
+    if (cache && cache->blocks[size_class]) {
+        block_header_t* block = cache->blocks[size_class];
+        cache->blocks[size_class] = block->next;
+        cache->counts[size_class]--;
+        block->next = NULL;
+        return (void*)((char*)block + sizeof(block_header_t));
+    }
+
+    // Chercher un bloc libre dans la classe appropriée, en agrandissant
+    // le tas d'un chunk si aucune liste ne peut servir la demande
+    pthread_mutex_lock(&manager->lock);
+    for (int i = size_class; i < VA_NUM_SIZE_CLASSES; i++) {
+        if (i == VA_NUM_SIZE_CLASSES - 1 && manager->free_lists[i] == NULL) {
+            if (add_chunk(manager) != 0) break;
+        }
+        if (manager->free_lists[i] != NULL) {
+            block_header_t* block = manager->free_lists[i];
+
             // Retirer le bloc de la liste
-            memory_manager.free_lists[i] = block->next;
+            manager->free_lists[i] = block->next;
             if (block->next) {
                 block->next->prev = NULL;
             }
-            
-            // Diviser le bloc si nécessaire
-            if (i > size_class) {
-                split_block(block, size_class);
+
+            // Diviser le bloc si nécessaire (les chunks dépassent la plus grande classe)
+            if (block_total_size(block) > get_block_size(size_class)) {
+                split_block(manager, block, size_class);
             }
-            
+
             block->is_free = 0;
             block->next = NULL;
             block->prev = NULL;
-            
+            pthread_mutex_unlock(&manager->lock);
+
             return (void*)((char*)block + sizeof(block_header_t));
         }
     }
-    
-    // Si aucun bloc n'est disponible, allouer un nouveau bloc
-    size_t alloc_size = get_block_size(size_class);
-    void* ptr = mmap(NULL, alloc_size + sizeof(block_header_t),
-                    PROT_READ | PROT_WRITE,
-                    MAP_PRIVATE | MAP_ANONYMOUS,
-                    -1, 0);
-    
-    if (ptr == MAP_FAILED) {
-        return NULL;
-    }
-    
-    block_header_t* block = (block_header_t*)ptr;
-    block->size = alloc_size;
-    block->is_free = 0;
-    block->next = NULL;
-    block->prev = NULL;
-    
-    return (void*)((char*)block + sizeof(block_header_t));
+    pthread_mutex_unlock(&manager->lock);
+    return NULL;
 }
 
-void vafree(void* ptr) {
+void vafree(memory_manager_t* manager, void* ptr) {
     if (!ptr) return;
-    
+
     block_header_t* block = (block_header_t*)((char*)ptr - sizeof(block_header_t));
-    block->is_free = 1;
+    if (block_total_size(block) > VA_MAX_BLOCK_SIZE) {
+        vafree_large(manager, block);
+        return;
+    }
 
-    int size_class = get_size_class(block->size);
-    block->next = memory_manager.free_lists[size_class];
-    block->prev = NULL;
-    
-    if (memory_manager.free_lists[size_class]) {
-        memory_manager.free_lists[size_class]->prev = block;
+    // Les blocs en cache restent marqués occupés pour le tas
+    thread_cache_t* cache = get_thread_cache(manager);
+    int size_class = get_size_class(block_total_size(block));
+    if (cache && cache->counts[size_class] < VA_CACHE_BLOCKS_PER_CLASS) {
+        block->next = cache->blocks[size_class];
+        cache->blocks[size_class] = block;
+        cache->counts[size_class]++;
+        return;
+    }
+
+    pthread_mutex_lock(&manager->lock);
+    push_free_block(manager, block);
+    pthread_mutex_unlock(&manager->lock);
+}
+
+// Plus aucun thread ne doit utiliser le gestionnaire
+void cleanup_vallocator(memory_manager_t* manager) {
+    if (!manager->initialized) return;
+
+    // Les destructeurs ne sont plus appelés après la suppression de la clé
+    pthread_key_delete(manager->cache_key);
+    while (manager->caches) {
+        thread_cache_t* cache = manager->caches;
+        manager->caches = cache->next;
+        munmap(cache, sizeof(thread_cache_t));
     }
-    memory_manager.free_lists[size_class] = block;
+
+    // Grands blocs encore occupés, puis tous les chunks du tas
+    while (manager->large_blocks) {
+        block_header_t* block = manager->large_blocks;
+        manager->large_blocks = block->next;
+        munmap(block, block_total_size(block));
+    }
+    while (manager->chunks) {
+        heap_chunk_t* chunk = manager->chunks;
+        manager->chunks = chunk->next;
+        munmap(chunk, VA_HEAP_CHUNK_SIZE);
+    }
+    manager->chunk_count = 0;
+    for (int i = 0; i < VA_NUM_SIZE_CLASSES; i++) {
+        manager->free_lists[i] = NULL;
+    }
+    pthread_mutex_destroy(&manager->lock);
+    manager->initialized = 0;
 }
 
-void cleanup_vallocator(void) {
-    if (memory_manager.heap_start) {
-        munmap(memory_manager.heap_start, MAX_BLOCK_SIZE * 4);
-        memory_manager.heap_start = NULL;
-        for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
-            memory_manager.free_lists[i] = NULL;
+// Fragmentation externe : 1 - plus grand bloc libre / octets libres
+// (0 si toute la mémoire libre est d'un seul tenant). Les blocs des caches
+// des threads ne sont pas comptés comme libres.
+double vallocator_fragmentation(memory_manager_t* manager) {
+    size_t free_bytes = 0;
+    size_t largest = 0;
+
+    pthread_mutex_lock(&manager->lock);
+    for (int i = 0; i < VA_NUM_SIZE_CLASSES; i++) {
+        for (block_header_t* block = manager->free_lists[i]; block; block = block->next) {
+            size_t total = block_total_size(block);
+            free_bytes += total;
+            if (total > largest) largest = total;
         }
     }
-}
\ No newline at end of file
+    pthread_mutex_unlock(&manager->lock);
+
+    if (free_bytes == 0) return 0.0;
+    return 1.0 - (double)largest / (double)free_bytes;
+}
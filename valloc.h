@@ -1,33 +1,63 @@
-#ifndef VALLOC_H
-#define VALLOC_H
+#ifndef VALLOCATOR_H
+#define VALLOCATOR_H
 
-#define MIN_BLOCK_SIZE 16    // Plus petite taille de bloc (2^4)
-#define SMALL_BLOCK_SIZE 128
-#define NUM_SIZE_CLASSES 9   // Nombre de classes de tailles (de 2^4 à 2^12)
-#define MAX_BLOCK_SIZE 4096  // Plus grande taille de bloc (2^12)
+#define VA_MIN_BLOCK_SIZE 16    // Plus petite taille de bloc (2^4)
+#define VA_SMALL_BLOCK_SIZE 128
+#define VA_NUM_SIZE_CLASSES 9   // Nombre de classes de tailles (de 2^4 à 2^12)
+#define VA_MAX_BLOCK_SIZE 4096  // Plus grande taille de bloc (2^12)
+
+#define VA_CACHE_BLOCKS_PER_CLASS 32  // Blocs conservés par thread et par classe
+#define VA_HEAP_CHUNK_SIZE (VA_MAX_BLOCK_SIZE * 64)  // Taille (et alignement) d'un chunk du tas
 
 
 
 #include <stddef.h>
+#include <pthread.h>
 
 
 typedef struct block_header {
-    size_t size;           
-    struct block_header* next;  
-    struct block_header* prev;  
-    int is_free;          
+    size_t size;
+    struct block_header* next;
+    struct block_header* prev;
+    int is_free;
 } block_header_t;
 
 
-typedef struct {
-    block_header_t* free_lists[NUM_SIZE_CLASSES];  
-    void* heap_start;                              
+// Premier bloc de chaque chunk, jamais libéré : chaîne les chunks du gestionnaire
+typedef struct heap_chunk {
+    block_header_t header;
+    struct heap_chunk* next;
+} heap_chunk_t;
+
+
+struct memory_manager;
+
+// Cache d'un thread : blocs libérés par le thread, réutilisés sans verrou
+typedef struct thread_cache {
+    struct memory_manager* manager;
+    block_header_t* blocks[VA_NUM_SIZE_CLASSES];
+    int counts[VA_NUM_SIZE_CLASSES];
+    struct thread_cache* next;     // Registre des caches du gestionnaire
+} thread_cache_t;
+
+
+// Un tas indépendant : chaque appel reçoit le gestionnaire à utiliser
+typedef struct memory_manager {
+    block_header_t* free_lists[VA_NUM_SIZE_CLASSES];
+    heap_chunk_t* chunks;          // Chunks du tas, dont les blocs alimentent free_lists
+    size_t chunk_count;
+    block_header_t* large_blocks;  // Blocs au-delà de VA_MAX_BLOCK_SIZE, une projection chacun
+    pthread_mutex_t lock;          // Protège free_lists, les chunks, les grands blocs et les caches
+    pthread_key_t cache_key;       // Cache du thread courant pour ce gestionnaire
+    thread_cache_t* caches;
+    int initialized;
 } memory_manager_t;
 
 
-void* valloc(size_t size);
-void vafree(void* ptr);
-void init_vallocator(void);
-void cleanup_vallocator(void);
+int init_vallocator(memory_manager_t* manager);
+void* valloc_alloc(memory_manager_t* manager, size_t size);
+void vafree(memory_manager_t* manager, void* ptr);
+void cleanup_vallocator(memory_manager_t* manager);
+double vallocator_fragmentation(memory_manager_t* manager);
 
-#endif // VALLOC_H
+#endif // VALLOCATOR_H